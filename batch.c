@@ -0,0 +1,198 @@
+#include "batch.h"
+
+#if NUM_ROWS < 32
+#define WELL_PLANES 5 // bits of the deepest well count
+#else
+#define WELL_PLANES 6
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+int batch_add(board_batch_t *batch, const board_t *board) {
+    if (batch->count == BATCH_MAX) {
+        return -1;
+    }
+
+    int i = batch->count++;
+    for (int y = 0; y < NUM_ROWS; y++) {
+        batch->rows[y][i] = (board->rows[y] >> BOARD_WALL) & BATCH_PLAYFIELD;
+    }
+    batch->lines[i] = 0;
+    return i;
+}
+
+int batch_add_placement(board_batch_t *batch, const board_t *board, int x, int y, const shape_info_t *shape) {
+    row_t placed[4];
+    int lines = 0;
+
+    if (batch->count == BATCH_MAX) {
+        return -1;
+    }
+
+    // Only the rows under the shape change; a completed one is left out
+    // and everything above it moves down
+    for (int mapY = shape->top; mapY <= shape->bottom; mapY++) {
+        placed[mapY] = board->rows[y + mapY] | shape->masks[mapY] << (x + BOARD_WALL);
+    }
+
+    int i = batch->count++;
+    int to = NUM_ROWS - 1;
+    for (int from = NUM_ROWS - 1; from >= 0; from--) {
+        int mapY = from - y;
+        row_t row = mapY >= shape->top && mapY <= shape->bottom ? placed[mapY] : board->rows[from];
+        if (row == BOARD_FULL_ROW) {
+            lines++;
+            continue;
+        }
+        batch->rows[to--][i] = (row >> BOARD_WALL) & BATCH_PLAYFIELD;
+    }
+    while (to >= 0) {
+        batch->rows[to--][i] = 0;
+    }
+    batch->lines[i] = lines;
+    return i;
+}
+
+/* ------ KERNELS ----*/
+
+// Portable: four 16-bit lanes in a 64-bit integer
+#define KERNEL kernel_portable
+#define KERNEL_POPCOUNT popcount_portable
+#define KERNEL_TARGET
+#define LANES 4
+#define vec_t unsigned long long
+#define LOAD(p) load_portable(p)
+#define STORE(p, v) store_portable(p, v)
+#define SET(c) (0x0001000100010001ull * (unsigned short)(c))
+#define AND(a, b) ((a) & (b))
+#define OR(a, b) ((a) | (b))
+#define XOR(a, b) ((a) ^ (b))
+#define ADD(a, b) ((a) + (b))
+#define SUB(a, b) ((a) - (b))
+#define ANDNOT(a, b) (~(a) & (b))
+#define SHL(a, n) ((a) << (n))
+#define SHR(a, n) ((a) >> (n))
+
+static inline unsigned long long load_portable(const unsigned short *p) {
+    return p[0] | (unsigned long long)p[1] << 16 | (unsigned long long)p[2] << 32 | (unsigned long long)p[3] << 48;
+}
+
+static inline void store_portable(unsigned short *p, unsigned long long v) {
+    p[0] = v;
+    p[1] = v >> 16;
+    p[2] = v >> 32;
+    p[3] = v >> 48;
+}
+
+#include "batch_kernel.h"
+
+#undef KERNEL
+#undef KERNEL_POPCOUNT
+#undef KERNEL_TARGET
+#undef LANES
+#undef vec_t
+#undef LOAD
+#undef STORE
+#undef SET
+#undef AND
+#undef OR
+#undef XOR
+#undef ADD
+#undef SUB
+#undef ANDNOT
+#undef SHL
+#undef SHR
+
+#ifdef BATCH_X86
+
+// SSE2: eight lanes, always there on x86-64
+#define KERNEL kernel_sse2
+#define KERNEL_POPCOUNT popcount_sse2
+#define KERNEL_TARGET __attribute__((target("sse2")))
+#define LANES 8
+#define vec_t __m128i
+#define LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define STORE(p, v) _mm_storeu_si128((__m128i *)(p), v)
+#define SET(c) _mm_set1_epi16((short)(c))
+#define AND _mm_and_si128
+#define OR _mm_or_si128
+#define XOR _mm_xor_si128
+#define ADD _mm_add_epi16
+#define SUB _mm_sub_epi16
+#define ANDNOT _mm_andnot_si128
+#define SHL _mm_slli_epi16
+#define SHR _mm_srli_epi16
+
+#include "batch_kernel.h"
+
+#undef KERNEL
+#undef KERNEL_POPCOUNT
+#undef KERNEL_TARGET
+#undef LANES
+#undef vec_t
+#undef LOAD
+#undef STORE
+#undef SET
+#undef AND
+#undef OR
+#undef XOR
+#undef ADD
+#undef SUB
+#undef ANDNOT
+#undef SHL
+#undef SHR
+
+// AVX2: sixteen lanes, when the CPU has it
+#define KERNEL kernel_avx2
+#define KERNEL_POPCOUNT popcount_avx2
+#define KERNEL_TARGET __attribute__((target("avx2")))
+#define LANES 16
+#define vec_t __m256i
+#define LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define STORE(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+#define SET(c) _mm256_set1_epi16((short)(c))
+#define AND _mm256_and_si256
+#define OR _mm256_or_si256
+#define XOR _mm256_xor_si256
+#define ADD _mm256_add_epi16
+#define SUB _mm256_sub_epi16
+#define ANDNOT _mm256_andnot_si256
+#define SHL _mm256_slli_epi16
+#define SHR _mm256_srli_epi16
+
+#include "batch_kernel.h"
+
+#endif
+
+static const batch_kernel_t KERNELS[] = {
+    {"portable", 4, kernel_portable},
+#ifdef BATCH_X86
+    {"sse2", 8, kernel_sse2},
+    {"avx2", 16, kernel_avx2},
+#endif
+};
+
+int batch_kernels(const batch_kernel_t **kernels) {
+    int count = sizeof(KERNELS) / sizeof(KERNELS[0]);
+#ifdef BATCH_X86
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx2")) count--;
+    if (!__builtin_cpu_supports("sse2")) count--;
+#endif
+    *kernels = KERNELS;
+    return count;
+}
+
+void batch_features(const board_batch_t *batch, batch_features_t *features) {
+    static void (*run)(const board_batch_t *, batch_features_t *);
+
+    if (run == 0) {
+        const batch_kernel_t *kernels;
+        int count = batch_kernels(&kernels);
+        run = kernels[count - 1].run;
+    }
+    run(batch, features);
+}
@@ -0,0 +1,94 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "board.h"
+
+/* Module to measure many candidate boards at once, for the bots that
+score every placement of every shape they look at.
+
+A batch holds its boards as a structure of arrays: row y of every board
+sits side by side in rows[y], as a NUM_COLS-bit mask of the playfield
+with column x at bit x and no walls. A kernel then walks the rows once
+from the top for a whole group of boards, one 16-bit lane per board,
+and measures each board with a handful of masks and popcounts per row:
+  height:      the heights of all columns added up. A column counts in
+               every row at or below its top, so this adds up the
+               popcount of the union of the rows seen so far.
+  holes:       empty cells under that union.
+  bumpiness:   the height differences between neighboring columns,
+               the rows where exactly one of the two is covered.
+  transitions: changes between filled and empty going along each row,
+               the walls on either side counting as filled.
+  wells:       for every empty cell with filled cells (or a wall) on
+               both sides, how deep it is into its well: 1 at the top
+               of the well, 2 under that and so on. The depth of every
+               column's well is kept as a bit-sliced counter, one mask
+               per bit of the count.
+
+The same kernel is compiled for SSE2 (8 boards per step) and AVX2 (16
+boards) on x86 hosts and for plain 64-bit integers (4 boards per step,
+the popcounts done with shifts and masks within each lane) everywhere
+else. batch_features() runs the widest one the CPU supports.
+*/
+
+#define BATCH_MAX 128 // boards per batch, a multiple of every kernel's width
+#define BATCH_PLAYFIELD ((1 << NUM_COLS) - 1)
+
+typedef struct {
+    unsigned short rows[NUM_ROWS][BATCH_MAX]; // row y of each board, column x at bit x
+    unsigned char lines[BATCH_MAX]; // rows completed by the placement that made each board
+    int count;
+} board_batch_t;
+
+typedef struct {
+    unsigned short height[BATCH_MAX];
+    unsigned short holes[BATCH_MAX];
+    unsigned short bumpiness[BATCH_MAX];
+    unsigned short transitions[BATCH_MAX];
+    unsigned short wells[BATCH_MAX];
+} batch_features_t;
+
+typedef struct {
+    const char *name;
+    int lanes; // boards measured per step
+    void (*run)(const board_batch_t *batch, batch_features_t *features);
+} batch_kernel_t;
+
+/* 'batch_clear'
+
+Empties the batch.
+*/
+static inline void batch_clear(board_batch_t *batch) {
+    batch->count = 0;
+}
+
+/* 'batch_add'
+
+Adds the board as it is. Returns its index in the batch, or -1 if the
+batch is full.
+*/
+int batch_add(board_batch_t *batch, const board_t *board);
+
+/* 'batch_add_placement'
+
+Adds the board left after placing the shape at (x, y), where it must
+fit, and removing the rows it completes. The board itself is not
+changed. Returns its index in the batch, or -1 if the batch is full.
+*/
+int batch_add_placement(board_batch_t *batch, const board_t *board, int x, int y, const shape_info_t *shape);
+
+/* 'batch_features'
+
+Measures every board in the batch with the widest kernel this CPU
+supports.
+*/
+void batch_features(const board_batch_t *batch, batch_features_t *features);
+
+/* 'batch_kernels'
+
+Points 'kernels' at the kernels this CPU supports, narrowest first, and
+returns how many there are.
+*/
+int batch_kernels(const batch_kernel_t **kernels);
+
+#endif
@@ -0,0 +1,68 @@
+/* The body of a batch kernel, included once per instruction set by
+batch.c with these defined:
+  KERNEL      name of the function
+  KERNEL_POPCOUNT  name of its popcount helper
+  KERNEL_TARGET    attributes of both, e.g. the instruction set
+  LANES       boards per vector
+  vec_t       the vector type
+  LOAD(p)     a vector from LANES shorts at p
+  STORE(p, v) v to LANES shorts at p
+  SET(c)      c in every lane
+  AND, OR, XOR, ADD, SUB(a, b)
+  ANDNOT(a, b)  ~a & b
+  SHL, SHR(a, n)  shift every lane by n bits; bits a shift brings in
+                  from a neighboring lane are masked away below
+*/
+
+/* Private helper that counts the set bits of each 16-bit lane, holding
+   no more than 16 bits. */
+KERNEL_TARGET static inline vec_t KERNEL_POPCOUNT(vec_t v) {
+    v = SUB(v, AND(SHR(v, 1), SET(0x5555)));
+    v = ADD(AND(v, SET(0x3333)), AND(SHR(v, 2), SET(0x3333)));
+    v = AND(ADD(v, SHR(v, 4)), SET(0x0F0F));
+    return AND(ADD(v, SHR(v, 8)), SET(0x001F));
+}
+
+KERNEL_TARGET static void KERNEL(const board_batch_t *batch, batch_features_t *features) {
+    const vec_t playfield = SET(BATCH_PLAYFIELD);
+    const vec_t inner = SET(BATCH_PLAYFIELD >> 1); // pairs of neighboring columns
+    const vec_t walled = SET(1 | 1 << (NUM_COLS + 1)); // a row shifted up by one, between its walls
+    const vec_t edges = SET((1 << (NUM_COLS + 1)) - 1); // the NUM_COLS + 1 edges between cells and walls
+    const vec_t left_wall = SET(1);
+    const vec_t right_wall = SET(1 << (NUM_COLS - 1));
+
+    for (int b = 0; b < batch->count; b += LANES) {
+        vec_t covered = SET(0), height = SET(0), holes = SET(0), bumpiness = SET(0);
+        vec_t transitions = SET(0), wells = SET(0);
+        vec_t depth[WELL_PLANES];
+        for (int k = 0; k < WELL_PLANES; k++) depth[k] = SET(0);
+
+        for (int y = 0; y < NUM_ROWS; y++) {
+            vec_t row = LOAD(&batch->rows[y][b]);
+            covered = OR(covered, row);
+            height = ADD(height, KERNEL_POPCOUNT(covered));
+            holes = ADD(holes, KERNEL_POPCOUNT(ANDNOT(row, covered)));
+            bumpiness = ADD(bumpiness, KERNEL_POPCOUNT(AND(XOR(covered, SHR(covered, 1)), inner)));
+
+            vec_t bounded = OR(SHL(row, 1), walled);
+            transitions = ADD(transitions, KERNEL_POPCOUNT(AND(XOR(bounded, SHR(bounded, 1)), edges)));
+
+            // A well cell is empty between two filled ones; its depth counts
+            // up while the column stays a well and drops to 0 where it stops
+            vec_t well = ANDNOT(row, AND(AND(OR(SHL(row, 1), left_wall), OR(SHR(row, 1), right_wall)), playfield));
+            vec_t carry = well;
+            for (int k = 0; k < WELL_PLANES; k++) {
+                vec_t next_carry = AND(depth[k], carry);
+                depth[k] = AND(XOR(depth[k], carry), well);
+                carry = next_carry;
+                wells = ADD(wells, SHL(KERNEL_POPCOUNT(depth[k]), k));
+            }
+        }
+
+        STORE(&features->height[b], height);
+        STORE(&features->holes[b], holes);
+        STORE(&features->bumpiness[b], bumpiness);
+        STORE(&features->transitions[b], transitions);
+        STORE(&features->wells[b], wells);
+    }
+}
@@ -0,0 +1,226 @@
+#include "beam.h"
+
+/* ------ POOL ----*/
+
+/* Private helper that takes a node from the pool, or returns 0 if it
+   is empty. */
+static beam_node_t *node_alloc(beam_t *beam) {
+    if (beam->free_node < 0) {
+        return 0;
+    }
+    beam_node_t *node = &beam->nodes[beam->free_node];
+    beam->free_node = node->next == BEAM_NO_NODE ? -1 : node->next;
+    return node;
+}
+
+/* Private helper that gives a node back to the pool. */
+static void node_free(beam_t *beam, beam_node_t *node) {
+    node->next = beam->free_node < 0 ? BEAM_NO_NODE : beam->free_node;
+    beam->free_node = node - beam->nodes;
+}
+
+void beam_init(beam_t *beam, beam_node_t *nodes, int capacity, int width, int depth) {
+    if (capacity > BEAM_NO_NODE) capacity = BEAM_NO_NODE;
+    if (width > capacity / 2) width = capacity / 2;
+    if (width > BEAM_MAX_WIDTH) width = BEAM_MAX_WIDTH;
+    if (width < 1) width = 1;
+    if (depth > BEAM_MAX_DEPTH) depth = BEAM_MAX_DEPTH;
+    if (depth < 1) depth = 1;
+
+    beam->nodes = nodes;
+    beam->capacity = capacity;
+    beam->width = width;
+    beam->depth = depth;
+    beam->budget_us = 0;
+    beam->clock = 0;
+
+    beam->free_node = -1;
+    for (int i = capacity - 1; i >= 0; i--) {
+        node_free(beam, &nodes[i]);
+    }
+}
+
+void beam_budget(beam_t *beam, beam_clock_fn_t clock, unsigned int budget_us) {
+    beam->clock = clock;
+    beam->budget_us = clock ? budget_us : 0;
+}
+
+/* ------ SEARCH ----*/
+
+/* Private helper that offers a candidate to the next layer, which keeps
+   the 'width' best in a min-heap with the worst at the top. */
+static void offer(beam_t *beam, int *count, beam_candidate_t candidate) {
+    beam_candidate_t *heap = beam->best;
+    int i;
+
+    if (*count < beam->width) {
+        i = (*count)++;
+        while (i > 0 && heap[(i - 1) / 2].score > candidate.score) { // sift up
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = candidate;
+        return;
+    }
+
+    if (candidate.score <= heap[0].score) {
+        return;
+    }
+    for (i = 0; 2*i + 1 < *count; ) { // replace the worst and sift down
+        int child = 2*i + 1;
+        if (child + 1 < *count && heap[child + 1].score < heap[child].score) child++;
+        if (heap[child].score >= candidate.score) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = candidate;
+}
+
+/* Private helper that returns the index of the lowest set bit. */
+static int lowest_bit(unsigned int bits) {
+    int index = 0;
+    for (bits = (bits & -bits) - 1; bits; bits &= bits - 1) {
+        index++;
+    }
+    return index;
+}
+
+/* Private helper that scores the placements waiting in the batch and
+   offers them to the next layer. */
+static void flush(beam_t *beam, const bot_t *bot, int *count) {
+    const bot_weights_t *w = &bot->weights;
+    const batch_features_t *f = &beam->features;
+
+    batch_features(&beam->batch, &beam->features);
+    for (int i = 0; i < beam->batch.count; i++) {
+        beam_candidate_t candidate = beam->pending[i];
+        candidate.score += w->height * f->height[i] + w->lines * beam->batch.lines[i] +
+                           w->holes * f->holes[i] + w->bumpiness * f->bumpiness[i];
+        offer(beam, count, candidate);
+    }
+    beam->nodes_expanded += beam->batch.count;
+    batch_clear(&beam->batch);
+}
+
+/* Private helper that adds every landing of shape 'type' in 'reach' on
+   the board of 'node', the layer's position 'parent', to the batch. */
+static void expand(beam_t *beam, const bot_t *bot, const reach_t *reach, const beam_node_t *node,
+                   int parent, int type, int *count) {
+    for (int word = 0; word < REACH_WORDS; word++) {
+        for (unsigned int bits = reach->landed[word]; bits; bits &= bits - 1) {
+            unsigned int state = word * 32 + lowest_bit(bits);
+            int o, x, y;
+            reach_unpack(state, &o, &x, &y);
+            shape_t shape = {type, o};
+
+            if (beam->batch.count == BATCH_MAX) flush(beam, bot, count);
+            int i = batch_add_placement(&beam->batch, &node->board, x, y, shape_info(shape));
+            beam->pending[i].parent = parent;
+            beam->pending[i].state = state;
+            beam->pending[i].score = node->lines;
+        }
+    }
+}
+
+/* Private helper that returns 1 once the plan has used up its budget. */
+static int out_of_time(const beam_t *beam, unsigned int start) {
+    return beam->budget_us && beam->clock() - start >= beam->budget_us;
+}
+
+int beam_plan(beam_t *beam, bot_t *bot, const engine_t *engine) {
+    unsigned char queue[BEAM_MAX_DEPTH];
+    unsigned short next[BEAM_MAX_WIDTH];
+    unsigned int start = beam->clock ? beam->clock() : 0;
+    int layer_size = 0;
+
+    queue[0] = engine->curr.shape.type;
+    queue[1] = engine->next.type;
+    for (int i = 2; i < beam->depth; i++) {
+        queue[i] = pieces_peek(&engine->pieces, i - 2);
+    }
+    beam->nodes_expanded = 0;
+    beam->layers = 0;
+    batch_clear(&beam->batch);
+
+    // The first layer is the board as it is, with the shape in play searched from where it is
+    beam_node_t *root = node_alloc(beam);
+    root->board = engine->board;
+    root->lines = 0;
+    root->score = 0;
+    root->first = 0;
+    beam->layer[layer_size++] = root - beam->nodes;
+
+    reach_search(&bot->reach[0], &engine->board, &engine->curr);
+    bot->target = bot->reach[0].start;
+
+    for (int d = 0; d < beam->depth && layer_size > 0; d++) {
+        int count = 0, complete = 1;
+
+        for (int i = 0; i < layer_size; i++) {
+            const beam_node_t *node = &beam->nodes[beam->layer[i]];
+            if (d == 0) {
+                expand(beam, bot, &bot->reach[0], node, i, queue[0], &count);
+                continue;
+            }
+            if (out_of_time(beam, start)) {
+                complete = 0;
+                break;
+            }
+
+            // A position with no room for the next shape is lost and dies here
+            piece_t spawn = {{queue[d], 0}, engine->startingX, 0, 0};
+            if (reach_search(&beam->reach, &node->board, &spawn) > 0) {
+                expand(beam, bot, &beam->reach, node, i, queue[d], &count);
+            }
+        }
+        flush(beam, bot, &count);
+        if (!complete || count == 0) {
+            break;
+        }
+
+        // The best of a complete layer is the plan so far
+        int top = 0;
+        for (int c = 1; c < count; c++) {
+            if (beam->best[c].score > beam->best[top].score) top = c;
+        }
+        bot->target = d == 0 ? beam->best[top].state : beam->nodes[beam->layer[beam->best[top].parent]].first;
+        beam->layers = d + 1;
+        if (d + 1 == beam->depth || out_of_time(beam, start)) {
+            break;
+        }
+
+        // Place the shape for each kept candidate, then recycle the layer it came from
+        int next_size = 0;
+        for (int c = 0; c < count; c++) {
+            const beam_node_t *parent = &beam->nodes[beam->layer[beam->best[c].parent]];
+            beam_node_t *child = node_alloc(beam);
+            if (child == 0) break;
+
+            int o, x, y;
+            unsigned int cleared;
+            reach_unpack(beam->best[c].state, &o, &x, &y);
+            shape_t shape = {queue[d], o};
+            child->board = parent->board;
+            board_place(&child->board, x, y, shape_info(shape), queue[d]);
+            child->lines = parent->lines + bot->weights.lines * (int)board_clear_rows(&child->board, y, &cleared);
+            child->score = beam->best[c].score;
+            child->first = d == 0 ? beam->best[c].state : parent->first;
+            next[next_size++] = child - beam->nodes;
+        }
+
+        for (int i = 0; i < layer_size; i++) {
+            node_free(beam, &beam->nodes[beam->layer[i]]);
+        }
+        for (int i = 0; i < next_size; i++) {
+            beam->layer[i] = next[i];
+        }
+        layer_size = next_size;
+    }
+
+    for (int i = 0; i < layer_size; i++) {
+        node_free(beam, &beam->nodes[beam->layer[i]]);
+    }
+
+    beam->elapsed_us = beam->clock ? beam->clock() - start : 0;
+    return beam->nodes_expanded;
+}
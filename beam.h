@@ -0,0 +1,92 @@
+#ifndef BEAM_H
+#define BEAM_H
+
+#include "bot.h"
+#include "batch.h"
+
+/* Module for a beam search planner for the bot, looking as far ahead as
+the preview queue goes: the shape in play, the next shape and the
+PIECE_PREVIEW shapes after it.
+
+Each layer of the search places one more shape. Every position kept in
+the beam is expanded into all the landings of the shape, each scored by
+the rows cleared so far plus the bot's score of the board it leaves,
+and only the 'width' best of them are kept for the next layer. The
+boards are scored a batch at a time (see batch.h). The plan
+is the first move of the best position in the deepest layer reached.
+
+Positions are nodes from a pool the caller hands to beam_init(): a
+free list threaded through a fixed array, so no memory is allocated
+while planning. The nodes of a layer go back to the pool once the next
+layer is built, and all of them at the end of a plan, ready for the
+next shape.
+
+A plan has a time budget read from a clock function. When it runs out,
+the search stops after the position it is expanding and answers from
+the last complete layer, so the bot keeps up with a live game.
+*/
+
+#define BEAM_MAX_WIDTH 256
+#define BEAM_MAX_DEPTH (PIECE_PREVIEW + 2)
+#define BEAM_NO_NODE 0xFFFF // end of the free list
+
+// Returns a time in microseconds
+typedef unsigned int (*beam_clock_fn_t)(void);
+
+typedef struct {
+    board_t board;
+    int lines; // weighted score of the rows cleared on the way here
+    int score; // 'lines' plus the score of the board
+    unsigned short first; // landing of the shape in play this position comes from
+    unsigned short next; // next free node while in the pool
+} beam_node_t;
+
+typedef struct {
+    unsigned short parent; // position in the current layer
+    unsigned short state; // landing of the shape
+    int score;
+} beam_candidate_t;
+
+typedef struct beam {
+    beam_node_t *nodes; // the pool
+    int capacity;
+    int free_node; // first free node, -1 if none
+    int width;
+    int depth;
+    unsigned int budget_us; // time allowed per plan, 0 for no limit
+    beam_clock_fn_t clock;
+    reach_t reach; // search for the shapes after the one in play
+    beam_candidate_t best[BEAM_MAX_WIDTH]; // the next layer, a min-heap on score
+    board_batch_t batch; // placements waiting to be scored
+    batch_features_t features;
+    beam_candidate_t pending[BATCH_MAX]; // where each board in the batch comes from
+    unsigned short layer[BEAM_MAX_WIDTH]; // nodes of the current layer
+    int nodes_expanded; // placements scored by the last plan
+    int layers; // layers the last plan completed
+    unsigned int elapsed_us; // time the last plan took
+} beam_t;
+
+/* 'beam_init'
+
+Sets up a planner whose nodes come from 'nodes[0..capacity)'. A plan
+needs two layers of nodes, so the width is cut to capacity / 2 and to
+BEAM_MAX_WIDTH.
+*/
+void beam_init(beam_t *beam, beam_node_t *nodes, int capacity, int width, int depth);
+
+/* 'beam_budget'
+
+Limits every plan to 'budget_us' microseconds as told by 'clock'. A
+budget of 0 takes away the limit.
+*/
+void beam_budget(beam_t *beam, beam_clock_fn_t clock, unsigned int budget_us);
+
+/* 'beam_plan'
+
+Picks the spot for the shape in play and stores it as the bot's target,
+searching from where the shape is in bot->reach[0]. Returns the number
+of placements scored.
+*/
+int beam_plan(beam_t *beam, bot_t *bot, const engine_t *engine);
+
+#endif
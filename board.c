@@ -0,0 +1,278 @@
+#include "board.h"
+
+#ifdef BOARD_VERIFY_HASH
+#include <assert.h>
+#define VERIFY_HASH(board) assert((board)->hash == board_hash(board))
+#else
+#define VERIFY_HASH(board)
+#endif
+
+// One random key per bit of a row, rotated by the row for the key of a cell
+#define Z0 0x0bb399b747cc503dull
+#define Z1 0x9acd2c06026dee31ull
+#define Z2 0xf1d916640ae8732aull
+#define Z3 0xd3d71a7c02598d89ull
+#define Z4 0x2fc8ef872435b9fdull
+#define Z5 0x9d75dc92f022ee36ull
+#define Z6 0x3789684292aebabbull
+#define Z7 0x81eb55afe2d6a574ull
+#define Z8 0x88d37d70e871222bull
+#define Z9 0x5f467e3015506f99ull
+#define Z10 0x1958f2370efd5fbfull
+#define Z11 0x1344279353cad1c1ull
+#define Z12 0x4a3269eac52bd559ull
+#define Z13 0x2541cc37f2990fc9ull
+#define Z14 0x94ad7ac58e45a6ffull
+#define Z15 0xf71c24d2d964adccull
+
+static const unsigned long long ZOBRIST[16] = {
+    Z0, Z1, Z2, Z3, Z4, Z5, Z6, Z7, Z8, Z9, Z10, Z11, Z12, Z13, Z14, Z15,
+};
+
+/* The key of every byte of a row mask, so a whole row hashes with two
+   lookups: the keys of the bits set in byte value m, for the low byte
+   (bits 0-7) and the high byte (bits 8-15), built by the preprocessor. */
+#define BYTE_KEY(m, a, b, c, d, e, f, g, h) \
+    (((m) & 1 ? a : 0) ^ ((m) & 2 ? b : 0) ^ ((m) & 4 ? c : 0) ^ ((m) & 8 ? d : 0) ^ \
+     ((m) & 16 ? e : 0) ^ ((m) & 32 ? f : 0) ^ ((m) & 64 ? g : 0) ^ ((m) & 128 ? h : 0))
+#define LOW_KEY(m) BYTE_KEY(m, Z0, Z1, Z2, Z3, Z4, Z5, Z6, Z7)
+#define HIGH_KEY(m) BYTE_KEY(m, Z8, Z9, Z10, Z11, Z12, Z13, Z14, Z15)
+#define KEYS4(K, m) K(m), K((m) + 1), K((m) + 2), K((m) + 3)
+#define KEYS16(K, m) KEYS4(K, m), KEYS4(K, (m) + 4), KEYS4(K, (m) + 8), KEYS4(K, (m) + 12)
+#define KEYS64(K, m) KEYS16(K, m), KEYS16(K, (m) + 16), KEYS16(K, (m) + 32), KEYS16(K, (m) + 48)
+#define KEYS256(K) KEYS64(K, 0), KEYS64(K, 64), KEYS64(K, 128), KEYS64(K, 192)
+
+static const unsigned long long LOW_KEYS[256] = {KEYS256(LOW_KEY)};
+static const unsigned long long HIGH_KEYS[256] = {KEYS256(HIGH_KEY)};
+
+/* Private helper that moves a row key to row 'y'. 7 is odd, so each of
+   up to 64 rows gets its own rotation. */
+static inline unsigned long long rotate_to_row(unsigned long long key, int y) {
+    int r = (7 * y) & 63;
+    return r ? (key << r) | (key >> (64 - r)) : key;
+}
+
+/* Private helper that hashes the filled cells of a row mask as if it
+   were row 0, leaving out the walls. */
+static inline unsigned long long row_key(unsigned int mask) {
+    mask &= ~BOARD_EMPTY_ROW & BOARD_FULL_ROW;
+    return LOW_KEYS[mask & 0xFF] ^ HIGH_KEYS[mask >> 8];
+}
+
+void board_init(board_t *board) {
+    for (int y = 0; y < NUM_ROWS; y++) {
+        board->rows[y] = BOARD_EMPTY_ROW;
+        board->slot[y] = y;
+        board->filled[y] = 0;
+        for (int x = 0; x < NUM_COLS; x++) {
+            board->colors[y][x] = 0;
+        }
+    }
+
+    for (int x = 0; x < NUM_COLS; x++) {
+        board->height[x] = 0;
+    }
+    board->total = 0;
+    board->hash = 0;
+}
+
+unsigned int board_fits(const board_t *board, int x, int y, const shape_info_t *shape) {
+    // 1. Check the bounding box against the playfield bounds
+    if (x + shape->left < 0 || x + shape->right >= NUM_COLS ||
+        y + shape->top < 0 || y + shape->bottom >= NUM_ROWS) {
+        return 0;
+    }
+
+    // 2. Check that no block is placed under the rows of the shape
+    for (int mapY = shape->top; mapY <= shape->bottom; mapY++) {
+        if (((unsigned int)shape->masks[mapY] << (x + BOARD_WALL)) & board->rows[y + mapY]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+void board_place(board_t *board, int x, int y, const shape_info_t *shape, int type) {
+    for (int i = 0; i < SHAPE_CELLS; i++) {
+        int cellX = x + shape->cells[i].x;
+        int cellY = y + shape->cells[i].y;
+
+        if (cellX >= 0 && cellX < NUM_COLS && cellY >= 0 && cellY < NUM_ROWS) {
+            board->rows[cellY] |= 1 << (cellX + BOARD_WALL);
+            board->hash ^= rotate_to_row(ZOBRIST[cellX + BOARD_WALL], cellY);
+            board->filled[cellY]++;
+            board->total++;
+            board->colors[board->slot[cellY]][cellX] = type + 1;
+            if (NUM_ROWS - cellY > board->height[cellX]) {
+                board->height[cellX] = NUM_ROWS - cellY;
+            }
+        }
+    }
+
+    VERIFY_HASH(board);
+}
+
+unsigned int board_row_full(const board_t *board, int y) {
+    return board->filled[y] == NUM_COLS;
+}
+
+/* Private helper that sets the height of the columns in 'remaining' (as
+   row mask bits) by scanning down from row 'from', which must be at or
+   above their top filled cells. A column with none is 0 high. */
+static void update_heights(board_t *board, int from, unsigned int remaining) {
+    for (int x = 0; x < NUM_COLS; x++) {
+        if (remaining & (1u << (x + BOARD_WALL))) board->height[x] = 0;
+    }
+
+    for (int y = from; y < NUM_ROWS && remaining; y++) {
+        unsigned int hits = board->rows[y] & remaining;
+        if (hits == 0) {
+            continue;
+        }
+
+        remaining &= ~hits;
+        for (int x = 0; x < NUM_COLS; x++) {
+            if (hits & (1u << (x + BOARD_WALL))) board->height[x] = NUM_ROWS - y;
+        }
+    }
+}
+
+void board_rebuild(board_t *board) {
+    update_heights(board, 0, ~BOARD_EMPTY_ROW & BOARD_FULL_ROW);
+
+    board->total = 0;
+    for (int y = 0; y < NUM_ROWS; y++) {
+        board->filled[y] = 0;
+        for (int x = 0; x < NUM_COLS; x++) {
+            if (board->rows[y] & (1 << (x + BOARD_WALL))) board->filled[y]++;
+        }
+        board->total += board->filled[y];
+    }
+    board->hash = board_hash(board);
+}
+
+unsigned int board_is_empty(const board_t *board) {
+    return board->total == 0;
+}
+
+unsigned int board_clear_rows(board_t *board, int top, unsigned int *cleared) {
+    int bottom = top + 3;
+    if (top < 0) top = 0;
+    if (bottom >= NUM_ROWS) bottom = NUM_ROWS - 1;
+
+    *cleared = 0;
+    int highest = -1, lowest = -1; // first and last full row, everything below the last stays put
+    for (int y = top; y <= bottom; y++) {
+        if (board->filled[y] == NUM_COLS) {
+            *cleared |= 1u << y;
+            if (highest < 0) highest = y;
+            lowest = y;
+        }
+    }
+
+    if (lowest < 0) {
+        return 0;
+    }
+
+    // Zero the cleared rows' storage, it becomes the empty rows at the top
+    unsigned char recycled[4];
+    unsigned int count = 0;
+    unsigned long long full = row_key(BOARD_FULL_ROW);
+    for (int y = lowest; y >= top; y--) {
+        if (*cleared & (1u << y)) {
+            board->hash ^= rotate_to_row(full, y);
+            recycled[count++] = board->slot[y];
+            for (int x = 0; x < NUM_COLS; x++) {
+                board->colors[board->slot[y]][x] = 0;
+            }
+        }
+    }
+
+    // The rows above the stack are empty and stay where they are
+    int tallest = 0;
+    for (int x = 0; x < NUM_COLS; x++) {
+        if (board->height[x] > tallest) tallest = board->height[x];
+    }
+    int stack = NUM_ROWS - tallest;
+
+    // Walk up from the lowest full row, dropping every surviving row into the
+    // next free slot. The rows between two cleared ones all move the same
+    // distance, so their keys are gathered a row apart with one fixed
+    // rotation each and the band is rotated into place as a whole
+    int to = lowest;
+    unsigned long long band = 0;
+    for (int from = lowest - 1; from >= stack; from--) {
+        if (*cleared & (1u << from)) {
+            unsigned long long keys = rotate_to_row(band, from + 1);
+            board->hash ^= keys ^ rotate_to_row(keys, to - from);
+            band = 0;
+            continue;
+        }
+        band = rotate_to_row(band, 1) ^ row_key(board->rows[from]);
+        board->rows[to] = board->rows[from];
+        board->filled[to] = board->filled[from];
+        board->slot[to--] = board->slot[from];
+    }
+    unsigned long long keys = rotate_to_row(band, stack);
+    board->hash ^= keys ^ rotate_to_row(keys, to + 1 - stack);
+
+    for (unsigned int i = 0; i < count; i++, to--) {
+        board->rows[to] = BOARD_EMPTY_ROW;
+        board->filled[to] = 0;
+        board->slot[to] = recycled[i];
+    }
+    board->total -= count*NUM_COLS;
+
+    // Every column has a cell in the highest cleared row, so its top was at
+    // or above it. A top above it moved down with all the rows cleared;
+    // only the columns that row was the top of look for a new one, in the
+    // rows that were below it and now start count rows lower
+    unsigned int topped = 0;
+    for (int x = 0; x < NUM_COLS; x++) {
+        if (board->height[x] > NUM_ROWS - highest) board->height[x] -= count;
+        else topped |= 1u << (x + BOARD_WALL);
+    }
+    update_heights(board, highest + count, topped);
+
+    VERIFY_HASH(board);
+    return count;
+}
+
+int board_drop_row(const board_t *board, int x, int y, const shape_info_t *shape) {
+    int land = NUM_ROWS;
+    for (int mapX = shape->left; mapX <= shape->right; mapX++) { // every column in between is filled
+        int stop = NUM_ROWS - board->height[x + mapX] - 1 - shape->bottom_profile[mapX];
+        if (stop < land) land = stop;
+    }
+
+    if (land >= y) { // the shape is above the skyline in all of its columns
+        return land;
+    }
+
+    // The shape is tucked under an overhang, walk it down the slow way
+    while (board_fits(board, x, y + 1, shape)) {
+        y++;
+    }
+    return y;
+}
+
+unsigned long long board_row_hash(const board_t *board, int y) {
+    return rotate_to_row(row_key(board->rows[y]), y);
+}
+
+unsigned long long board_hash(const board_t *board) {
+    unsigned long long hash = 0;
+    for (int y = 0; y < NUM_ROWS; y++) {
+        for (int x = 0; x < NUM_COLS; x++) {
+            if (board->rows[y] & (1 << (x + BOARD_WALL))) {
+                hash ^= rotate_to_row(ZOBRIST[x + BOARD_WALL], y);
+            }
+        }
+    }
+    return hash;
+}
+
+char board_cell(const board_t *board, int x, int y) {
+    return board->colors[board->slot[y]][x];
+}
@@ -0,0 +1,178 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+#include "shape_table.h"
+
+/* Module for the playfield bitboard that tracks placed blocks.
+
+Each row of the board is one 16-bit occupancy mask. Column 'x' of the
+playfield lives at bit (x + BOARD_WALL). The bits on either side of the
+playfield are always set, so a row is full exactly when its mask is
+BOARD_FULL_ROW.
+
+Shapes are handed to the board as their SHAPE_INFO entry. Collision
+only visits the rows inside the shape's bounding box with one shift and
+AND each, and placement only touches the shape's four filled cells.
+
+The color of every placed cell is kept in a separate array which only
+the renderer reads. Its rows are reached through 'slot', which maps each
+row of the board to the row of storage holding its colors. A line clear
+moves slot indices instead of copying cells: the storage of a cleared
+row is zeroed and handed to the new empty row at the top. Indices are
+used rather than pointers so a board_t can still be copied by value.
+
+The board also keeps the height of every column (the skyline), which
+board_place() and board_clear_rows() keep up to date; a clear lowers
+every column by the rows it removed and only looks for a new top in
+the columns the highest removed row was the top of. With the bottom
+profile of a shape it gives the row the shape lands on without walking
+the shape down one row at a time.
+
+It also counts the filled cells of every row and of the whole board.
+The row counts move with their rows on a line clear, so a row is full
+when its count reaches NUM_COLS and the board is empty (a perfect
+clear) when the total drops to 0.
+
+Finally it keeps a 64-bit Zobrist hash of which cells are filled, to
+key caches of searched positions and to compare boards cheaply. The key
+of the cell at bit b of row y is the key of bit b rotated left by 7y, so
+a row moved down by a line clear is rehashed with one rotation instead
+of cell by cell, from its key looked up a byte of its mask at a time:
+board_place() updates the hash for four cells, and board_clear_rows()
+only for the rows that moved. Compile with
+BOARD_VERIFY_HASH defined to check it against a full recompute after
+every change.
+
+The size of the board is fixed at compile time by BOARD_GEOMETRY: the
+standard 10 x 20, or a wide or tall board for stress tests. Every loop
+over rows and columns, here and in the modules built on the board, runs
+to a constant the compiler can unroll and specialize for that size.
+*/
+
+// Board geometries, picked at compile time with -DBOARD_GEOMETRY=...
+#define BOARD_STANDARD 0 // 10 x 20
+#define BOARD_WIDE 1 // 13 x 20, as wide as a 16-bit row allows
+#define BOARD_TALL 2 // 10 x 32, as tall as the cleared-rows mask allows
+
+#ifndef BOARD_GEOMETRY
+#define BOARD_GEOMETRY BOARD_STANDARD
+#endif
+
+#if BOARD_GEOMETRY == BOARD_WIDE
+#define NUM_ROWS 20
+#define NUM_COLS 13
+#elif BOARD_GEOMETRY == BOARD_TALL
+#define NUM_ROWS 32
+#define NUM_COLS 10
+#else
+#define NUM_ROWS 20
+#define NUM_COLS 10
+#endif
+
+#define BOARD_WALL 3 // wall bits left of column 0, shapes may sit as far left as x = -3
+#define BOARD_FULL_ROW 0xFFFF
+#define BOARD_EMPTY_ROW (BOARD_FULL_ROW & ~(((1 << NUM_COLS) - 1) << BOARD_WALL))
+
+#if NUM_COLS + BOARD_WALL > 16
+#error "NUM_COLS does not fit in a 16-bit board row"
+#endif
+
+#if NUM_ROWS > 32
+#error "NUM_ROWS does not fit in the cleared-rows mask"
+#endif
+
+typedef unsigned short row_t;
+
+typedef struct {
+    row_t rows[NUM_ROWS]; // occupancy mask of each row, walls included
+    unsigned char slot[NUM_ROWS]; // row of 'colors' that holds the colors of each row
+    char colors[NUM_ROWS][NUM_COLS]; // shape type + 1 of each placed cell, 0 if empty
+    unsigned char height[NUM_COLS]; // rows from the floor to the top filled cell of each column
+    unsigned char filled[NUM_ROWS]; // filled cells in each row
+    unsigned int total; // filled cells on the whole board
+    unsigned long long hash; // Zobrist hash of the filled cells
+} board_t;
+
+/* 'board_init'
+
+Empties the board.
+*/
+void board_init(board_t *board);
+
+/* 'board_fits'
+
+Returns 1 if the shape fits at (x, y): every filled cell is inside the
+playfield and not on a placed block. Returns 0 if not.
+*/
+unsigned int board_fits(const board_t *board, int x, int y, const shape_info_t *shape);
+
+/* 'board_place'
+
+ORs the shape into the occupancy masks and records 'type' + 1 as the
+color of each of its cells. Cells outside the playfield are dropped.
+*/
+void board_place(board_t *board, int x, int y, const shape_info_t *shape, int type);
+
+/* 'board_row_full'
+
+Returns 1 if every cell of row 'y' is filled, 0 if not.
+*/
+unsigned int board_row_full(const board_t *board, int y);
+
+/* 'board_clear_rows'
+
+Removes every full row among the four rows starting at 'top' (the rows a
+shape landed in) and compacts the board in one pass, moving each row
+above them straight to its final position. Only row masks and slot
+indices move; the cells of the removed rows are zeroed and recycled as
+the new rows at the top. Returns the number of rows
+removed and sets bit y of 'cleared' for every removed row y.
+*/
+unsigned int board_clear_rows(board_t *board, int top, unsigned int *cleared);
+
+/* 'board_drop_row'
+
+Returns the lowest row the shape reaches when it falls straight down
+from (x, y), where it must fit. Answered from the skyline unless the
+shape is already tucked under an overhang, in which case it is walked
+down row by row.
+*/
+int board_drop_row(const board_t *board, int x, int y, const shape_info_t *shape);
+
+/* 'board_rebuild'
+
+Recomputes the skyline and the fill counts from the row masks.
+board_place() and board_clear_rows() keep them up to date themselves;
+this is for boards that were filled in some other way.
+*/
+void board_rebuild(board_t *board);
+
+/* 'board_is_empty'
+
+Returns 1 if no blocks are placed on the board, e.g. after a perfect
+clear. Returns 0 if not.
+*/
+unsigned int board_is_empty(const board_t *board);
+
+/* 'board_hash'
+
+Computes the Zobrist hash of the board from scratch, cell by cell. The
+board keeps it up to date in board->hash; this is the reference it is
+verified against.
+*/
+unsigned long long board_hash(const board_t *board);
+
+/* 'board_row_hash'
+
+Returns the part of the board's hash that the cells of row 'y' make up,
+with two table lookups, for code that moves rows on its own.
+*/
+unsigned long long board_row_hash(const board_t *board, int y);
+
+/* 'board_cell'
+
+Returns the shape type + 1 of the block at (x, y), or 0 if it is empty.
+*/
+char board_cell(const board_t *board, int x, int y);
+
+#endif
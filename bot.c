@@ -0,0 +1,202 @@
+#include "bot.h"
+#include "beam.h"
+
+#define PLAYFIELD (((1u << NUM_COLS) - 1) << BOARD_WALL)
+
+void bot_init(bot_t *bot, const bot_weights_t *weights) {
+    bot->weights = *weights;
+    bot->planned = 0;
+    bot->depth = 1;
+    bot->tt = 0;
+    bot->beam = 0;
+}
+
+static int lookahead(bot_t *bot, const board_t *board, const unsigned char *queue, int depth,
+                     int level, int *nodes);
+
+/* Private helper that counts the set bits of a row. */
+static int count_bits(unsigned int bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1) {
+        count++;
+    }
+    return count;
+}
+
+void bot_features(const board_t *board, int x, int y, const shape_info_t *shape, bot_features_t *features) {
+    row_t rows[NUM_ROWS];
+    int lines = 0;
+
+    // Place the shape into a copy of the masks and drop its completed rows
+    for (int r = 0; r < NUM_ROWS; r++) {
+        rows[r] = board->rows[r];
+    }
+    for (int mapY = shape->top; mapY <= shape->bottom; mapY++) {
+        rows[y + mapY] |= shape->masks[mapY] << (x + BOARD_WALL);
+        lines += rows[y + mapY] == BOARD_FULL_ROW;
+    }
+    if (lines > 0) {
+        int to = y + shape->bottom;
+        for (int from = to; from >= 0; from--) {
+            if (rows[from] != BOARD_FULL_ROW) rows[to--] = rows[from];
+        }
+        while (to >= 0) rows[to--] = BOARD_EMPTY_ROW;
+    }
+
+    // Walk down from the top: a column's height is set by its first filled
+    // cell, and every empty cell under a filled one is a hole
+    int heights[NUM_COLS] = {0};
+    unsigned int covered = 0;
+    int holes = 0;
+    for (int r = 0; r < NUM_ROWS; r++) {
+        unsigned int row = rows[r] & PLAYFIELD;
+        holes += count_bits(covered & ~row);
+        for (unsigned int fresh = row & ~covered; fresh; fresh &= fresh - 1) {
+            int column = count_bits((fresh & -fresh) - 1) - BOARD_WALL;
+            heights[column] = NUM_ROWS - r;
+        }
+        covered |= row;
+    }
+
+    int height = heights[0], bumpiness = 0;
+    for (int c = 1; c < NUM_COLS; c++) {
+        height += heights[c];
+        bumpiness += heights[c] > heights[c - 1] ? heights[c] - heights[c - 1] : heights[c - 1] - heights[c];
+    }
+
+    features->height = height;
+    features->lines = lines;
+    features->holes = holes;
+    features->bumpiness = bumpiness;
+}
+
+int bot_score(const bot_weights_t *w, const board_t *board, int x, int y, const shape_info_t *info) {
+    bot_features_t f;
+    bot_features(board, x, y, info, &f);
+    return w->height * f.height + w->lines * f.lines + w->holes * f.holes + w->bumpiness * f.bumpiness;
+}
+
+/* Private helper that scores every landing in bot->reach[level] for the
+   shapes queue[0..depth), placing queue[0] there and searching the rest
+   from the spawn spot. Returns the best score and sets 'best_state'. */
+static int search_landings(bot_t *bot, const board_t *board, const unsigned char *queue, int depth,
+                           int level, unsigned int *best_state, int *nodes) {
+    const reach_t *reach = &bot->reach[level];
+    int best = BOT_LOST, best_distance = 0, evaluated = 0;
+    *best_state = reach->start;
+
+    for (int word = 0; word < REACH_WORDS; word++) {
+        for (unsigned int bits = reach->landed[word]; bits; bits &= bits - 1) {
+            unsigned int state = word * 32 + count_bits((bits & -bits) - 1);
+            int o, x, y, score;
+            reach_unpack(state, &o, &x, &y);
+            shape_t shape = {queue[0], o};
+            const shape_info_t *info = shape_info(shape);
+            (*nodes)++;
+
+            if (depth == 1) {
+                score = bot_score(&bot->weights, board, x, y, info);
+            } else {
+                // Place it for real and look at what the next shapes can do
+                board_t after = *board;
+                unsigned int cleared;
+                board_place(&after, x, y, info, queue[0]);
+                int lines = board_clear_rows(&after, y, &cleared);
+                score = lookahead(bot, &after, queue + 1, depth - 1, level + 1, nodes);
+                if (score > BOT_LOST) score += bot->weights.lines * lines;
+            }
+
+            // Ties go to the spot closest to where the shape starts
+            int start_x = (int)(reach->start % REACH_WIDTH) - BOARD_WALL;
+            int distance = x > start_x ? x - start_x : start_x - x;
+            if (evaluated++ == 0 || score > best || (score == best && distance < best_distance)) {
+                best = score;
+                best_distance = distance;
+                *best_state = state;
+            }
+        }
+    }
+
+    return best;
+}
+
+/* Private helper that searches the shapes queue[0..depth) on a board
+   where queue[0] is about to come into play, going through the
+   transposition table if the bot has one. */
+static int lookahead(bot_t *bot, const board_t *board, const unsigned char *queue, int depth,
+                     int level, int *nodes) {
+    unsigned long long key = 0;
+    unsigned int move;
+    int score;
+
+    if (bot->tt) {
+        key = tt_key(board->hash, queue, depth);
+        if (tt_probe(bot->tt, key, &score, &move)) return score;
+    }
+
+    piece_t spawn = {{queue[0], 0}, bot->spawn_x, 0, 0};
+    if (reach_search(&bot->reach[level], board, &spawn) == 0) {
+        score = BOT_LOST; // no room for it, game over
+        move = 0;
+    } else {
+        score = search_landings(bot, board, queue, depth, level, &move, nodes);
+    }
+
+    if (bot->tt) tt_store(bot->tt, key, depth, score, move);
+    return score;
+}
+
+int bot_plan(bot_t *bot, const engine_t *engine) {
+    unsigned char queue[BOT_MAX_DEPTH];
+    int nodes = 0;
+
+    if (!bot->planned || bot->spawned != engine->spawned) {
+        if (bot->tt) tt_new_search(bot->tt);
+    }
+    bot->spawned = engine->spawned;
+    bot->planned = 1;
+    bot->spawn_x = engine->startingX;
+    if (bot->beam) {
+        return beam_plan(bot->beam, bot, engine);
+    }
+
+    // The shape in play, the next one and as many from the preview as it looks ahead
+    queue[0] = engine->curr.shape.type;
+    queue[1] = engine->next.type;
+    for (int i = 2; i < bot->depth; i++) {
+        queue[i] = pieces_peek(&engine->pieces, i - 2);
+    }
+
+    // The shape in play may have moved already, so it is searched from where it is
+    reach_search(&bot->reach[0], &engine->board, &engine->curr);
+    search_landings(bot, &engine->board, queue, bot->depth, 0, &bot->target, &nodes);
+
+    return nodes;
+}
+
+void bot_lookahead(bot_t *bot, int depth, tt_t *tt) {
+    if (depth < 1) depth = 1;
+    if (depth > BOT_MAX_DEPTH) depth = BOT_MAX_DEPTH;
+    bot->depth = depth;
+    bot->tt = tt;
+}
+
+void bot_beam(bot_t *bot, struct beam *beam) {
+    bot->beam = beam;
+}
+
+input_t bot_next_input(bot_t *bot, const engine_t *engine) {
+    if (!bot->planned || bot->spawned != engine->spawned) {
+        bot_plan(bot, engine);
+    } else {
+        // Gravity or a blocked input may have moved the shape off its path
+        reach_search(&bot->reach[0], &engine->board, &engine->curr);
+        if (!reach_has(bot->reach[0].landed, bot->target)) {
+            bot_plan(bot, engine);
+        }
+    }
+
+    input_t path[REACH_MAX_PATH];
+    int len = reach_path(&bot->reach[0], bot->target, path);
+    return len > 0 ? path[0] : INPUT_DOWN;
+}
@@ -0,0 +1,127 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "engine.h"
+#include "reach.h"
+#include "tt.h"
+
+struct beam;
+
+/* Module for a computer player.
+
+When a new shape comes into play, the bot searches every spot it can
+reach with the real controls (see reach.h), tucks and slides under
+overhangs included. It scores the board each of these placements would
+leave behind and picks the best one, then hands out the inputs that
+take the shape there one at a time, the same left/right/down/rotate
+inputs a player makes. Gravity keeps moving the shape meanwhile, so
+the path is searched again from wherever the shape is before every
+input, and a new spot is picked if the old one went out of reach.
+
+A board is scored from its row masks alone, after removing the rows the
+placement completes, as a weighted sum of
+  height:    the heights of all columns added up
+  lines:     the rows the placement completes
+  holes:     empty cells with a filled cell somewhere above them
+  bumpiness: the height differences between neighboring columns
+Weights are integers, higher scores are better.
+
+A shape rarely has more than a few dozen placements, so planning takes
+a search and a few dozen board evaluations: well within one gravity
+tick.
+
+With bot_lookahead() the bot also plays out the next shape, and the
+ones after it in the preview queue, on the board each placement leaves.
+A placement is then worth the best score the following shapes can
+reach, plus the rows it clears on the way. The positions searched go
+into a transposition table, if it is given one, so those reached again
+through another order of moves, or again on the next turn, cost a
+lookup.
+
+With bot_beam() the planning is handed to a beam search instead (see
+beam.h), which looks further ahead on a fixed budget of nodes and time.
+*/
+
+typedef struct {
+    int height;
+    int lines;
+    int holes;
+    int bumpiness;
+} bot_weights_t;
+
+// The classic hand-tuned weights, scaled to integers
+#define BOT_DEFAULT_WEIGHTS { -51, 76, -36, -18 }
+
+#define BOT_MAX_DEPTH 4 // shapes the bot can look ahead, the one in play included
+#define BOT_LOST (-(1 << 28)) // score of a position where the next shape has no room
+
+typedef struct {
+    int height;
+    int lines;
+    int holes;
+    int bumpiness;
+} bot_features_t;
+
+typedef struct {
+    bot_weights_t weights;
+    unsigned int spawned; // engine->spawned when the shape in play was planned for
+    int planned; // 1 once the shape in play has a target
+    unsigned int target; // reach state the shape in play should land in
+    int depth; // shapes looked at per plan, 1 is only the one in play
+    int spawn_x; // column new shapes come into play at
+    tt_t *tt; // positions searched so far, or 0
+    struct beam *beam; // planner used instead of the lookahead, or 0
+    reach_t reach[BOT_MAX_DEPTH]; // one search per shape looked at, [0] is from the shape in play
+} bot_t;
+
+/* 'bot_init'
+
+Sets up a bot that scores boards with 'weights' and only looks at the
+shape in play.
+*/
+void bot_init(bot_t *bot, const bot_weights_t *weights);
+
+/* 'bot_lookahead'
+
+Makes the bot look 'depth' shapes ahead, up to BOT_MAX_DEPTH, keeping
+searched positions in 'tt' (or nowhere if it is 0).
+*/
+void bot_lookahead(bot_t *bot, int depth, tt_t *tt);
+
+/* 'bot_beam'
+
+Makes the bot plan with the beam search 'beam' (or with its own
+lookahead again if it is 0).
+*/
+void bot_beam(bot_t *bot, struct beam *beam);
+
+/* 'bot_features'
+
+Measures the board left after placing the shape at (x, y), where it
+must fit, and clearing the rows it completes.
+*/
+void bot_features(const board_t *board, int x, int y, const shape_info_t *shape, bot_features_t *features);
+
+/* 'bot_score'
+
+Scores the board left after placing the shape at (x, y), where it must
+fit, and clearing the rows it completes.
+*/
+int bot_score(const bot_weights_t *weights, const board_t *board, int x, int y, const shape_info_t *shape);
+
+/* 'bot_plan'
+
+Picks the best reachable spot for the shape in play. Returns the number
+of placements it evaluated, at all depths.
+*/
+int bot_plan(bot_t *bot, const engine_t *engine);
+
+/* 'bot_next_input'
+
+Returns the next input that takes the shape in play to its spot,
+planning first if the shape is new. Once the shape is there, the bot
+keeps pressing down until gravity lands it.
+*/
+input_t bot_next_input(bot_t *bot, const engine_t *engine);
+
+#endif
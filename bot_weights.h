@@ -0,0 +1,12 @@
+#ifndef BOT_WEIGHTS_H
+#define BOT_WEIGHTS_H
+
+/* Weights the bot plays with on the Pi, written by host/tune.
+
+These are still the hand-tuned defaults from bot.h; a tuning run
+replaces this file with the best weights it finds.
+*/
+
+#define BOT_TUNED_WEIGHTS { -51, 76, -36, -18 } // height, lines, holes, bumpiness
+
+#endif
@@ -0,0 +1,87 @@
+#include "damage.h"
+
+void damage_init(damage_t *damage, int width, int height) {
+    damage->width = width;
+    damage->height = height;
+    damage->buffers[0] = damage->buffers[1] = 0;
+    damage->count[0] = damage->count[1] = 0;
+
+    damage_stats_t none = {0};
+    damage->stats = none;
+}
+
+/* Private helper that tells which of the two buffers is at 'buffer',
+   learning their addresses as it first sees them. */
+static int buffer_index(damage_t *damage, void *buffer) {
+    if (damage->buffers[0] == 0) damage->buffers[0] = buffer;
+    if (buffer == damage->buffers[0]) return 0;
+    if (damage->buffers[1] == 0) damage->buffers[1] = buffer;
+    return 1;
+}
+
+/* Private helper that returns whether rectangle 'a' covers all of 'b'. */
+static int covers(const damage_rect_t *a, const damage_rect_t *b) {
+    return a->x <= b->x && a->y <= b->y && a->x + a->w >= b->x + b->w && a->y + a->h >= b->y + b->h;
+}
+
+/* Private helper that grows 'into' to the box around it and 'rect'. */
+static void merge(damage_rect_t *into, const damage_rect_t *rect) {
+    int right = into->x + into->w > rect->x + rect->w ? into->x + into->w : rect->x + rect->w;
+    int bottom = into->y + into->h > rect->y + rect->h ? into->y + into->h : rect->y + rect->h;
+
+    if (rect->x < into->x) into->x = rect->x;
+    if (rect->y < into->y) into->y = rect->y;
+    into->w = right - into->x;
+    into->h = bottom - into->y;
+}
+
+void damage_add(damage_t *damage, void *draw, int x, int y, int w, int h) {
+    // Clipped to the screen, like gl draws it
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if (x + w > damage->width) w = damage->width - x;
+    if (y + h > damage->height) h = damage->height - y;
+    if (w <= 0 || h <= 0) return;
+
+    damage_rect_t rect = {x, y, w, h};
+    int other = !buffer_index(damage, draw);
+    damage_rect_t *rects = damage->rects[other];
+    int count = damage->count[other];
+
+    // Drop what the new rectangle covers, and the new one if already covered
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (covers(&rects[i], &rect)) return;
+        if (!covers(&rect, &rects[i])) rects[kept++] = rects[i];
+    }
+
+    if (kept < DAMAGE_MAX_RECTS) {
+        rects[kept++] = rect;
+    } else {
+        for (int i = 1; i < kept; i++) {
+            merge(&rects[0], &rects[i]);
+        }
+        merge(&rects[0], &rect);
+        kept = 1;
+    }
+    damage->count[other] = kept;
+}
+
+int damage_take(damage_t *damage, void *draw, damage_rect_t rects[DAMAGE_MAX_RECTS]) {
+    int b = buffer_index(damage, draw);
+    int count = damage->count[b];
+
+    for (int i = 0; i < count; i++) {
+        rects[i] = damage->rects[b][i];
+        damage->stats.pixels += (unsigned long long)rects[i].w * rects[i].h;
+    }
+    damage->count[b] = 0;
+    damage->stats.takes++;
+    return count;
+}
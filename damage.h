@@ -0,0 +1,57 @@
+#ifndef DAMAGE_H
+#define DAMAGE_H
+
+/* Module to keep track of what each of two screen buffers is missing.
+
+Whatever is drawn into one buffer is damage to the other, which still
+shows the old pixels there. The damage is kept as a short list of
+rectangles per buffer, so after a swap only those regions need to be
+copied from the buffer on screen into the new draw buffer, rather than
+the whole screen.
+
+Buffers are told apart by their address, so this only does the
+bookkeeping and builds on the host too; mymodule.c does the copying.
+*/
+
+#define DAMAGE_MAX_RECTS 16
+
+typedef struct {
+    int x, y, w, h;
+} damage_rect_t;
+
+typedef struct {
+    unsigned long long takes; // calls to damage_take()
+    unsigned long long pixels; // pixels in the rectangles they gave
+} damage_stats_t;
+
+typedef struct {
+    int width, height; // of the screen, which rectangles are clipped to
+    void *buffers[2]; // address of each buffer, learned as they come
+    damage_rect_t rects[2][DAMAGE_MAX_RECTS]; // the regions each buffer is missing
+    int count[2];
+    damage_stats_t stats;
+} damage_t;
+
+/* 'damage_init'
+
+Starts with two buffers of a 'width' x 'height' screen that both show
+the same pixels.
+*/
+void damage_init(damage_t *damage, int width, int height);
+
+/* 'damage_add'
+
+Records that a region was drawn into buffer 'draw', so the other one is
+missing it. Once a buffer misses more rectangles than the list holds,
+they are merged into the box around all of them.
+*/
+void damage_add(damage_t *damage, void *draw, int x, int y, int w, int h);
+
+/* 'damage_take'
+
+Gives the regions buffer 'draw' is missing in 'rects' and forgets them,
+for when it is about to get them copied in. Returns how many there are.
+*/
+int damage_take(damage_t *damage, void *draw, damage_rect_t rects[DAMAGE_MAX_RECTS]);
+
+#endif
@@ -0,0 +1,115 @@
+#include "engine.h"
+
+/* Private helper that draws a new shape in its starting orientation. */
+static shape_t new_shape(engine_t *engine) {
+    shape_t shape;
+
+    shape.type = pieces_next(&engine->pieces);
+    shape.orientation = 0;
+
+    return shape;
+}
+
+void engine_init(engine_t *engine, piece_mode_t mode) {
+    engine->pieces.mode = mode;
+    engine->mostrows = 0;
+    engine->startingX = (NUM_COLS / 2) - 2;
+
+    engine_new_game(engine, 0);
+}
+
+void engine_new_game(engine_t *engine, unsigned int seed) {
+    board_init(&engine->board);
+    engine->seed = seed;
+    pieces_init(&engine->pieces, seed, engine->pieces.mode);
+
+    engine->curr.shape = new_shape(engine);
+    engine->curr.x = engine->startingX;
+    engine->curr.y = 0;
+    engine->curr.visible = 0;
+    engine->next = new_shape(engine);
+
+    engine->rowscleared = 0;
+    engine->over = 0;
+    engine->spawned = 0;
+}
+
+/* Private helper that places the landed shape, clears any rows it
+   completed and brings in the next shape. */
+static int land(engine_t *engine, event_t events[ENGINE_MAX_EVENTS]) {
+    int count = 0;
+    piece_t *curr = &engine->curr;
+
+    board_place(&engine->board, curr->x, curr->y, shape_info(curr->shape), curr->shape.type);
+    events[count].type = EVENT_PLACED;
+    events[count++].to = *curr;
+
+    unsigned int cleared;
+    unsigned int rows = board_clear_rows(&engine->board, curr->y, &cleared);
+    if (rows > 0) {
+        engine->rowscleared += rows;
+        events[count].type = EVENT_CLEARED;
+        events[count].cleared = cleared;
+        events[count++].count = rows;
+    }
+
+    curr->shape = engine->next;
+    curr->x = engine->startingX;
+    curr->y = 0;
+    curr->visible = 0;
+    engine->next = new_shape(engine);
+    engine->spawned++;
+    events[count++].type = EVENT_SPAWNED;
+
+    return count;
+}
+
+int engine_step(engine_t *engine, input_t input, event_t events[ENGINE_MAX_EVENTS]) {
+    if (engine->over || input == INPUT_NONE) {
+        return 0;
+    }
+
+    piece_t moved = engine->curr;
+
+    switch (input) {
+    case INPUT_LEFT:
+        moved.x--;
+        break;
+    case INPUT_RIGHT:
+        moved.x++;
+        break;
+    case INPUT_ROTATE:
+        moved.shape.orientation = (moved.shape.orientation + 1) % NUM_ORIENTATIONS;
+        break;
+    default: // INPUT_DOWN and INPUT_GRAVITY move down a row, or bring the shape onto the screen
+        if (moved.visible) {
+            moved.y++;
+        } else {
+            moved.visible = 1;
+        }
+        break;
+    }
+
+    if (board_fits(&engine->board, moved.x, moved.y, shape_info(moved.shape))) {
+        events[0].type = EVENT_MOVED;
+        events[0].from = engine->curr;
+        events[0].to = moved;
+        engine->curr = moved;
+        return 1;
+    }
+
+    if (input != INPUT_GRAVITY) { // blocked moves are simply ignored
+        return 0;
+    }
+
+    if (!engine->curr.visible) { // Game over!
+        engine->over = 1;
+        if (engine->rowscleared > engine->mostrows) {
+            engine->mostrows = engine->rowscleared;
+        }
+        events[0].type = EVENT_GAME_OVER;
+        return 1;
+    }
+
+    return land(engine, events);
+}
@@ -0,0 +1,90 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "board.h"
+#include "shape_table.h"
+#include "rng.h"
+
+/* Module for the Tetris rules, independent of the screen and timers.
+
+The whole game lives in an engine_t. engine_step() applies one input
+(a key press, a glove move or a gravity tick) to it and reports what
+happened as a short list of events, which the caller is free to draw,
+log or ignore. Nothing in here touches gl, the armtimer or the clock,
+so the engine builds on a Linux host and can simulate games as fast as
+the CPU allows.
+
+Shapes come from a seeded pieces_t, so a game is fully determined by
+its seed and its inputs.
+*/
+
+#define ENGINE_MAX_EVENTS 4 // most events one step can produce: placed, cleared, spawned
+
+typedef enum {
+    INPUT_NONE = 0,
+    INPUT_LEFT,
+    INPUT_RIGHT,
+    INPUT_DOWN,
+    INPUT_ROTATE,
+    INPUT_GRAVITY,
+} input_t;
+
+typedef enum {
+    EVENT_MOVED = 0, // the shape in play moved, rotated or appeared at the top
+    EVENT_PLACED, // the shape in play landed and was placed on the board
+    EVENT_CLEARED, // full rows were removed from the board
+    EVENT_SPAWNED, // a new shape is in play and a new next shape was drawn
+    EVENT_GAME_OVER, // the shape in play has no room to appear
+} event_type_t;
+
+// Where the shape in play is. It is not on screen until the first gravity tick or down input.
+typedef struct {
+    shape_t shape;
+    int x;
+    int y;
+    int visible;
+} piece_t;
+
+typedef struct {
+    event_type_t type;
+    piece_t from; // EVENT_MOVED: where the shape was
+    piece_t to; // EVENT_MOVED: where it is now. EVENT_PLACED: where it landed
+    unsigned int cleared; // EVENT_CLEARED: bit y is set for each removed row y
+    unsigned int count; // EVENT_CLEARED: number of rows removed
+} event_t;
+
+typedef struct {
+    board_t board; // placed blocks
+    piece_t curr; // shape in play
+    shape_t next; // shape shown on the side
+    int startingX; // column every shape starts in
+    unsigned int rowscleared; // score of the current game
+    unsigned int mostrows; // best score since engine_init()
+    int over; // 1 once the game is lost
+    unsigned int seed; // seed the current game's shapes were drawn from
+    unsigned int spawned; // shapes brought into play after the first one
+    pieces_t pieces; // shapes after 'next'
+} engine_t;
+
+/* 'engine_init'
+
+Sets up an engine whose games draw their shapes in the given mode and
+starts the first game from seed 0.
+*/
+void engine_init(engine_t *engine, piece_mode_t mode);
+
+/* 'engine_new_game'
+
+Empties the board and starts a new game whose shapes are drawn from
+'seed', keeping the best score.
+*/
+void engine_new_game(engine_t *engine, unsigned int seed);
+
+/* 'engine_step'
+
+Applies one input to the game and writes the resulting events to
+'events'. Returns the number of events written.
+*/
+int engine_step(engine_t *engine, input_t input, event_t events[ENGINE_MAX_EVENTS]);
+
+#endif
@@ -0,0 +1,1662 @@
+/* Host benchmarks for the Tetris game logic.
+
+Runs every suite by default, or only the suites named on the command
+line, e.g. "./bench collision". Each suite prints one line per variant
+with its throughput so runs can be compared before and after a change.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "board.h"
+#include "engine.h"
+#include "snapshot.h"
+#include "bot.h"
+#include "reach.h"
+#include "beam.h"
+#include "batch.h"
+#include "render.h"
+#include "damage.h"
+#include "tile.h"
+#include "span.h"
+#include "softfb.h"
+#include "fb.h"
+
+/* ------ HELPERS ----*/
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void report(const char *suite, const char *variant, double count, double seconds, const char *unit) {
+    printf("%-12s %-30s %12.0f %s/sec\n", suite, variant, count / seconds, unit);
+}
+
+// Keeps the optimizer from throwing away benchmark results
+static volatile unsigned int sink;
+
+/* Expands a table entry back into the 4x4 char map that shapes used to
+   carry around, for the reference implementations below. */
+static void bench_map(const shape_info_t *shape, char map[4][4]) {
+    for (int mapY = 0; mapY < 4; mapY++) {
+        for (int mapX = 0; mapX < 4; mapX++) {
+            map[mapY][mapX] = (shape->masks[mapY] >> mapX) & 1;
+        }
+    }
+}
+
+static void set_cell(board_t *board, int x, int y, char color) {
+    if (color) {
+        board->rows[y] |= 1 << (x + BOARD_WALL);
+    } else {
+        board->rows[y] &= ~(1 << (x + BOARD_WALL));
+    }
+    board->colors[board->slot[y]][x] = color;
+}
+
+/* Compares what two boards hold, regardless of how their rows are stored. */
+static int same_board(const board_t *a, const board_t *b) {
+    for (int y = 0; y < NUM_ROWS; y++) {
+        if (a->rows[y] != b->rows[y]) return 0;
+        for (int x = 0; x < NUM_COLS; x++) {
+            if (board_cell(a, x, y) != board_cell(b, x, y)) return 0;
+        }
+    }
+    return 1;
+}
+
+/* Fills the bottom 'height' rows of the board at random with roughly
+   'percent' percent of the cells filled. */
+static void random_board(board_t *board, int height, int percent) {
+    board_init(board);
+    for (int y = NUM_ROWS - height; y < NUM_ROWS; y++) {
+        for (int x = 0; x < NUM_COLS; x++) {
+            if (rand() % 100 < percent) set_cell(board, x, y, rand() % 7 + 1);
+        }
+    }
+    board_rebuild(board);
+}
+
+/* Drops a shape from the top by walking it down one row at a time, the
+   way lowest_spot() used to. Returns 0 if it does not fit at the top. */
+static int walk_drop(const board_t *board, int x, const shape_info_t *shape, int *y) {
+    *y = -shape->top;
+    if (!board_fits(board, x, *y, shape)) return 0;
+    while (board_fits(board, x, *y + 1, shape)) (*y)++;
+    return 1;
+}
+
+/* ------ COLLISION ----*/
+
+/* The char-grid collision check the board replaced: one byte per cell,
+   every cell of the 4x4 map visited on every call. */
+static unsigned int grid_valid_shape_position(int x, int y, const char map[4][4], char **grid) {
+    for (int mapY = 0; mapY < 4; mapY++) {
+        for (int mapX = 0; mapX < 4; mapX++) {
+            if (map[mapY][mapX] == 1) {
+                if ((y + mapY) < 0 || (y + mapY) >= NUM_ROWS) {
+                    return 0;
+                }
+                if ((x + mapX) < 0 || (x + mapX) >= NUM_COLS) {
+                    return 0;
+                }
+                if (grid[y + mapY][x + mapX] > 0) {
+                    return 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+#define COLLISION_QUERIES 4096
+#define COLLISION_ROUNDS 2000
+
+static void bench_collision(void) {
+    board_t board;
+    random_board(&board, 12, 60);
+
+    char *rows[NUM_ROWS];
+    char cells[NUM_ROWS][NUM_COLS];
+    for (int y = 0; y < NUM_ROWS; y++) {
+        rows[y] = cells[y];
+        for (int x = 0; x < NUM_COLS; x++) cells[y][x] = board_cell(&board, x, y);
+    }
+
+    static int qx[COLLISION_QUERIES], qy[COLLISION_QUERIES];
+    static const shape_info_t *qshape[COLLISION_QUERIES];
+    static char qmap[COLLISION_QUERIES][4][4];
+    for (int i = 0; i < COLLISION_QUERIES; i++) {
+        qx[i] = rand() % (NUM_COLS + 4) - 3;
+        qy[i] = rand() % NUM_ROWS;
+        qshape[i] = &SHAPE_INFO[rand() % NUM_SHAPES][rand() % NUM_ORIENTATIONS];
+        bench_map(qshape[i], qmap[i]);
+    }
+
+    // Both backends have to agree before their speed means anything
+    for (int i = 0; i < COLLISION_QUERIES; i++) {
+        if (grid_valid_shape_position(qx[i], qy[i], qmap[i], rows) != board_fits(&board, qx[i], qy[i], qshape[i])) {
+            printf("collision: grid and bitboard disagree at x=%d y=%d\n", qx[i], qy[i]);
+            exit(1);
+        }
+    }
+
+    double count = (double)COLLISION_QUERIES * COLLISION_ROUNDS;
+    unsigned int hits = 0;
+
+    double start = now();
+    for (int r = 0; r < COLLISION_ROUNDS; r++) {
+        for (int i = 0; i < COLLISION_QUERIES; i++) {
+            hits += grid_valid_shape_position(qx[i], qy[i], qmap[i], rows);
+        }
+    }
+    report("collision", "char grid", count, now() - start, "checks");
+
+    start = now();
+    for (int r = 0; r < COLLISION_ROUNDS; r++) {
+        for (int i = 0; i < COLLISION_QUERIES; i++) {
+            hits += board_fits(&board, qx[i], qy[i], qshape[i]);
+        }
+    }
+    report("collision", "bitboard", count, now() - start, "checks");
+
+    sink = hits;
+}
+
+/* ------ LINE CLEAR ----*/
+
+/* The row-at-a-time clear the compaction pass replaced: every full row
+   shifts every row above it down by one, cell by cell. It keeps the same
+   fill counts, skyline and hash as board_clear_rows(), the way a row
+   shift would: each moved row is rehashed where it leaves and where it
+   lands, and each column's top drops by one or is looked for again. */
+static void copy_row(board_t *board, int from, int to) {
+    board->hash ^= board_row_hash(board, to);
+    board->rows[to] = board->rows[from];
+    board->hash ^= board_row_hash(board, to);
+    board->filled[to] = board->filled[from];
+    for (int x = 0; x < NUM_COLS; x++) {
+        board->colors[board->slot[to]][x] = board->colors[board->slot[from]][x];
+    }
+}
+
+static unsigned int shift_clear_rows(board_t *board, int top) {
+    unsigned int count = 0;
+    for (int shapeY = 0; shapeY < 4 && top + shapeY < NUM_ROWS; shapeY++) {
+        int full = top + shapeY;
+        if (board->rows[full] != BOARD_FULL_ROW) continue;
+
+        count++;
+        for (int y = full; y > 0; y--) copy_row(board, y - 1, y);
+        board->hash ^= board_row_hash(board, 0);
+        board->rows[0] = BOARD_EMPTY_ROW;
+        board->filled[0] = 0;
+        for (int x = 0; x < NUM_COLS; x++) board->colors[board->slot[0]][x] = 0;
+        board->total -= NUM_COLS;
+
+        for (int x = 0; x < NUM_COLS; x++) {
+            if (board->height[x] > NUM_ROWS - full) {
+                board->height[x]--;
+                continue;
+            }
+            board->height[x] = 0;
+            for (int y = full + 1; y < NUM_ROWS; y++) {
+                if (board->rows[y] & (1 << (x + BOARD_WALL))) {
+                    board->height[x] = NUM_ROWS - y;
+                    break;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+/* Builds a board whose bottom four rows hold 'lines' full rows, the rest
+   of them one cell short, under a stack 'stack' rows tall. */
+static void clear_board(board_t *board, int lines, int stack) {
+    random_board(board, 4 + stack, 70);
+    for (int y = NUM_ROWS - 4; y < NUM_ROWS; y++) {
+        for (int x = 0; x < NUM_COLS; x++) set_cell(board, x, y, 1);
+        if (y - (NUM_ROWS - 4) >= lines) set_cell(board, y % NUM_COLS, y, 0);
+    }
+    board_rebuild(board);
+}
+
+#define CLEAR_ROUNDS 2000000
+
+static void bench_lineclear(void) {
+    static const char *NAMES[] = {"single", "double", "triple", "tetris"};
+    static const struct {
+        const char *name;
+        int stack;
+    } BOARDS[] = {{"full", NUM_ROWS - 6}, {"sparse", 2}};
+
+    for (int b = 0; b < 2; b++) {
+        for (int lines = 1; lines <= 4; lines++) {
+            board_t template, board, check;
+            clear_board(&template, lines, BOARDS[b].stack);
+            unsigned int total = 0, cleared;
+
+            // Both clears must leave the same board behind
+            board = template;
+            check = template;
+            shift_clear_rows(&board, NUM_ROWS - 4);
+            board_clear_rows(&check, NUM_ROWS - 4, &cleared);
+            if (!same_board(&board, &check) || board.hash != check.hash || board.total != check.total ||
+                memcmp(board.height, check.height, sizeof(board.height)) != 0 ||
+                memcmp(board.filled, check.filled, sizeof(board.filled)) != 0) {
+                printf("lineclear: compaction and row shifting disagree on a %s\n", NAMES[lines - 1]);
+                exit(1);
+            }
+
+            char variant[64];
+            double start = now();
+            for (int r = 0; r < CLEAR_ROUNDS; r++) {
+                board = template;
+                total += shift_clear_rows(&board, NUM_ROWS - 4);
+            }
+            double shift = now() - start;
+            snprintf(variant, sizeof(variant), "%s %s, row shift", BOARDS[b].name, NAMES[lines - 1]);
+            report("lineclear", variant, CLEAR_ROUNDS, shift, "clears");
+
+            start = now();
+            for (int r = 0; r < CLEAR_ROUNDS; r++) {
+                board = template;
+                total += board_clear_rows(&board, NUM_ROWS - 4, &cleared);
+            }
+            double rotation = now() - start;
+            snprintf(variant, sizeof(variant), "%s %s, slot rotation", BOARDS[b].name, NAMES[lines - 1]);
+            report("lineclear", variant, CLEAR_ROUNDS, rotation, "clears");
+
+            printf("%-12s %-30s %12.2fx the row shift%s\n", "lineclear", variant, shift / rotation,
+                   shift < rotation ? ", slower" : "");
+
+            sink = total;
+        }
+    }
+}
+
+/* ------ SKYLINE ----*/
+
+#define SKYLINE_GAMES 500
+#define SKYLINE_QUERIES 4096
+#define SKYLINE_ROUNDS 1000
+
+/* Checks board_drop_row() against walking the shape down from every
+   position it fits in, and the incrementally kept skyline and fill
+   counts against ones rebuilt from scratch. Exits on the first
+   disagreement. */
+static void check_skyline(const board_t *board) {
+    board_t rebuilt = *board;
+    board_rebuild(&rebuilt);
+    if (memcmp(rebuilt.height, board->height, sizeof(board->height)) != 0) {
+        printf("skyline: kept heights differ from rebuilt ones\n");
+        exit(1);
+    }
+    if (memcmp(rebuilt.filled, board->filled, sizeof(board->filled)) != 0 || rebuilt.total != board->total) {
+        printf("skyline: kept fill counts differ from rebuilt ones\n");
+        exit(1);
+    }
+
+    for (int type = 0; type < NUM_SHAPES; type++) {
+        for (int orientation = 0; orientation < NUM_ORIENTATIONS; orientation++) {
+            const shape_info_t *shape = &SHAPE_INFO[type][orientation];
+            for (int x = -shape->left; x + shape->right < NUM_COLS; x++) {
+                for (int y = -shape->top; y + shape->bottom < NUM_ROWS; y++) {
+                    if (!board_fits(board, x, y, shape)) continue;
+
+                    int walked = y;
+                    while (board_fits(board, x, walked + 1, shape)) walked++;
+                    if (board_drop_row(board, x, y, shape) != walked) {
+                        printf("skyline: drop of type %d/%d from (%d, %d) should land on %d\n", type, orientation, x, y, walked);
+                        exit(1);
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void bench_skyline(void) {
+    // Games of random straight drops, with their holes and line clears
+    unsigned int checked = 0;
+    for (int game = 0; game < SKYLINE_GAMES; game++) {
+        board_t board;
+        board_init(&board);
+        for (;;) {
+            const shape_info_t *shape = &SHAPE_INFO[rand() % NUM_SHAPES][rand() % NUM_ORIENTATIONS];
+            int x = rand() % (NUM_COLS - shape->right + shape->left) - shape->left;
+            int y;
+            if (!walk_drop(&board, x, shape, &y)) break;
+
+            board_place(&board, x, y, shape, 0);
+            unsigned int cleared;
+            board_clear_rows(&board, y, &cleared);
+            check_skyline(&board);
+            checked++;
+        }
+    }
+
+    // Noise boards, full of overhangs the skyline cannot see under
+    for (int i = 0; i < SKYLINE_GAMES; i++) {
+        board_t board;
+        random_board(&board, rand() % NUM_ROWS, 40);
+        check_skyline(&board);
+        checked++;
+    }
+    printf("%-12s %-30s %12u boards\n", "skyline", "consistent with walking", checked);
+
+    board_t board;
+    random_board(&board, 8, 60);
+    static int qx[SKYLINE_QUERIES];
+    static const shape_info_t *qshape[SKYLINE_QUERIES];
+    for (int i = 0; i < SKYLINE_QUERIES; i++) {
+        qshape[i] = &SHAPE_INFO[rand() % NUM_SHAPES][rand() % NUM_ORIENTATIONS];
+        qx[i] = rand() % (NUM_COLS - qshape[i]->right + qshape[i]->left) - qshape[i]->left;
+    }
+
+    double count = (double)SKYLINE_QUERIES * SKYLINE_ROUNDS;
+    int total = 0, y;
+
+    double start = now();
+    for (int r = 0; r < SKYLINE_ROUNDS; r++) {
+        for (int i = 0; i < SKYLINE_QUERIES; i++) {
+            if (walk_drop(&board, qx[i], qshape[i], &y)) total += y;
+        }
+    }
+    report("skyline", "walk down", count, now() - start, "drops");
+
+    start = now();
+    for (int r = 0; r < SKYLINE_ROUNDS; r++) {
+        for (int i = 0; i < SKYLINE_QUERIES; i++) {
+            total += board_drop_row(&board, qx[i], -qshape[i]->top, qshape[i]);
+        }
+    }
+    report("skyline", "skyline", count, now() - start, "drops");
+
+    sink = total;
+}
+
+/* ------ ENGINE ----*/
+
+#define ENGINE_GAMES 20000
+
+/* Plays whole games headless with random key presses, one gravity tick
+   after every ten of them like the armtimer does on the Pi. */
+static void bench_engine(void) {
+    static engine_t engine;
+    engine_init(&engine, PIECES_RANDOM);
+
+    double steps = 0, pieces = 0;
+    double start = now();
+    for (int game = 0; game < ENGINE_GAMES; game++) {
+        engine_new_game(&engine, game);
+        for (int tick = 0; !engine.over; tick++) {
+            event_t events[ENGINE_MAX_EVENTS];
+            input_t input = (tick % 11 == 10) ? INPUT_GRAVITY : (input_t)(INPUT_LEFT + rand() % 4);
+            int count = engine_step(&engine, input, events);
+            for (int i = 0; i < count; i++) {
+                if (events[i].type == EVENT_PLACED) pieces++;
+            }
+            steps++;
+        }
+    }
+    double seconds = now() - start;
+
+    report("engine", "random play", ENGINE_GAMES, seconds, "games");
+    report("engine", "random play", steps, seconds, "steps");
+    report("engine", "random play", pieces, seconds, "pieces");
+}
+
+/* ------ PIECES ----*/
+
+#define PIECES_COUNT 50000000
+
+static void bench_pieces(void) {
+    static const char *NAMES[] = {"uniform", "7-bag"};
+
+    for (int mode = PIECES_RANDOM; mode <= PIECES_BAG; mode++) {
+        pieces_t pieces, replay;
+        pieces_init(&pieces, 107, mode);
+        pieces_init(&replay, 107, mode);
+
+        // The same seed must deal the same shapes, and a bag must hold each shape once
+        unsigned int seen = 0;
+        for (int i = 0; i < 7000; i++) {
+            int type = pieces_next(&pieces);
+            if (type != pieces_next(&replay) || type < 0 || type >= NUM_SHAPES) {
+                printf("pieces: %s sequence is not reproducible\n", NAMES[mode]);
+                exit(1);
+            }
+            seen |= 1 << type;
+            if (mode == PIECES_BAG && i % 7 == 6) {
+                if (seen != 0x7F) {
+                    printf("pieces: 7-bag dealt a shape twice\n");
+                    exit(1);
+                }
+                seen = 0;
+            }
+        }
+
+        unsigned int total = 0;
+        double start = now();
+        for (int i = 0; i < PIECES_COUNT; i++) {
+            total += pieces_next(&pieces);
+        }
+        report("pieces", NAMES[mode], PIECES_COUNT, now() - start, "pieces");
+        sink = total;
+    }
+}
+
+/* ------ SNAPSHOT ----*/
+
+#define SNAPSHOT_ROUNDS 2000000
+
+/* Feeds the engine 'steps' random inputs with regular gravity ticks,
+   drawing them from 'seed' so the same call can be repeated. */
+static void random_inputs(engine_t *engine, unsigned int seed, int steps) {
+    rng_t rng;
+    rng_seed(&rng, seed);
+    for (int tick = 0; tick < steps && !engine->over; tick++) {
+        event_t events[ENGINE_MAX_EVENTS];
+        input_t input = (tick % 11 == 10) ? INPUT_GRAVITY : (input_t)(INPUT_LEFT + rng_below(&rng, 4));
+        engine_step(engine, input, events);
+    }
+}
+
+static void bench_snapshot(void) {
+    static engine_t engine, restored;
+    snapshot_t snapshot, again;
+
+    for (int game = 0; game < 1000; game++) {
+        engine_init(&engine, game % 2 ? PIECES_BAG : PIECES_RANDOM);
+        engine_new_game(&engine, game);
+        random_inputs(&engine, game, rand() % 3000);
+        snapshot_take(&engine, &snapshot);
+
+        // Restoring and saving again must give back the same bytes...
+        engine_init(&restored, PIECES_RANDOM);
+        if (!snapshot_restore(&restored, &snapshot)) {
+            printf("snapshot: restore refused its own snapshot\n");
+            exit(1);
+        }
+        snapshot_take(&restored, &again);
+        if (memcmp(&snapshot, &again, sizeof(snapshot)) != 0) {
+            printf("snapshot: restore is not byte for byte\n");
+            exit(1);
+        }
+
+        // ...and the restored game has to play on exactly like the original
+        random_inputs(&engine, game + 1, 2000);
+        random_inputs(&restored, game + 1, 2000);
+        snapshot_take(&engine, &snapshot);
+        snapshot_take(&restored, &again);
+        if (memcmp(&snapshot, &again, sizeof(snapshot)) != 0 || !same_board(&engine.board, &restored.board)) {
+            printf("snapshot: restored game diverged from the original\n");
+            exit(1);
+        }
+    }
+    printf("%-12s %-30s %12d bytes\n", "snapshot", "size", SNAPSHOT_SIZE);
+
+    unsigned int total = 0;
+    double start = now();
+    for (int r = 0; r < SNAPSHOT_ROUNDS; r++) {
+        snapshot_take(&engine, &snapshot);
+        total += snapshot.bytes[r % SNAPSHOT_SIZE];
+    }
+    report("snapshot", "take", SNAPSHOT_ROUNDS, now() - start, "snapshots");
+
+    start = now();
+    for (int r = 0; r < SNAPSHOT_ROUNDS; r++) {
+        total += snapshot_restore(&restored, &snapshot);
+    }
+    report("snapshot", "restore", SNAPSHOT_ROUNDS, now() - start, "restores");
+
+    sink = total;
+}
+
+/* ------ HASH ----*/
+
+#define HASH_ROUNDS 2000000
+
+static void bench_hash(void) {
+    static engine_t engine, restored;
+    snapshot_t snapshot;
+
+    // The kept hash must match a full recompute after every step of a game
+    for (int game = 0; game < 200; game++) {
+        engine_init(&engine, PIECES_RANDOM);
+        engine_new_game(&engine, game);
+        rng_t rng;
+        rng_seed(&rng, game);
+        for (int tick = 0; !engine.over; tick++) {
+            event_t events[ENGINE_MAX_EVENTS];
+            input_t input = (tick % 11 == 10) ? INPUT_GRAVITY : (input_t)(INPUT_LEFT + rng_below(&rng, 4));
+            engine_step(&engine, input, events);
+            if (engine.board.hash != board_hash(&engine.board)) {
+                printf("hash: kept hash drifted from the board\n");
+                exit(1);
+            }
+        }
+
+        snapshot_take(&engine, &snapshot);
+        snapshot_restore(&restored, &snapshot);
+        if (restored.board.hash != engine.board.hash) {
+            printf("hash: restored board hashes differently\n");
+            exit(1);
+        }
+    }
+
+    static board_t boards[64];
+    for (int i = 0; i < 64; i++) {
+        random_board(&boards[i], rand() % 16, 70);
+    }
+
+    unsigned long long total = 0;
+    double start = now();
+    for (int r = 0; r < HASH_ROUNDS; r++) {
+        total ^= board_hash(&boards[r % 64]);
+    }
+    report("hash", "full recompute", HASH_ROUNDS, now() - start, "hashes");
+
+    // Boards whose bottom row an I lying down at the left completes
+    shape_t shape = {2, 0};
+    const shape_info_t *info = shape_info(shape);
+    int y = NUM_ROWS - 1 - info->bottom;
+    for (int i = 0; i < 64; i++) {
+        for (int x = 0; x < NUM_COLS; x++) set_cell(&boards[i], x, NUM_ROWS - 1, x < 4 ? 0 : 1);
+        for (int x = 0; x < 4; x++) set_cell(&boards[i], x, NUM_ROWS - 2, 0);
+        board_rebuild(&boards[i]);
+    }
+
+    for (int recompute = 0; recompute <= 1; recompute++) {
+        board_t board;
+        start = now();
+        for (int r = 0; r < HASH_ROUNDS; r++) {
+            unsigned int cleared;
+            board = boards[r % 64];
+            board_place(&board, -info->left, y, info, 2);
+            board_clear_rows(&board, y, &cleared);
+            total ^= recompute ? board_hash(&board) : board.hash;
+        }
+        report("hash", recompute ? "place and clear, recomputed" : "place and clear, kept", HASH_ROUNDS, now() - start, "rounds");
+    }
+    sink = total;
+}
+
+/* ------ REACH ----*/
+
+#define REACH_ROUNDS 20000
+
+static void bench_reach(void) {
+    static engine_t engine;
+    static reach_t reach;
+    static board_t boards[64];
+    double tucks = 0, drops = 0;
+
+    for (int i = 0; i < 64; i++) {
+        random_board(&boards[i], 4 + rand() % 8, 30 + rand() % 50);
+
+        // Half of them get a tunnel along the bottom that opens into a shaft on the right
+        if (i % 2) {
+            int floor = NUM_ROWS - 1 - rand() % 3;
+            for (int x = rand() % 4; x < NUM_COLS; x++) {
+                set_cell(&boards[i], x, floor, 0);
+                set_cell(&boards[i], x, floor - 1, 0);
+            }
+            for (int y = 0; y < floor; y++) {
+                set_cell(&boards[i], NUM_COLS - 2, y, 0);
+                set_cell(&boards[i], NUM_COLS - 1, y, 0);
+            }
+        }
+
+        for (int y = 0; y < NUM_ROWS; y++) {
+            if (boards[i].rows[y] == BOARD_FULL_ROW) set_cell(&boards[i], rand() % NUM_COLS, y, 0);
+        }
+        board_rebuild(&boards[i]);
+    }
+
+    // Every landing must be reached by feeding its path to the engine, and
+    // every straight drop must be among the landings
+    engine_init(&engine, PIECES_RANDOM);
+    for (int b = 0; b < 64; b++) {
+        for (int type = 0; type < NUM_SHAPES; type++) {
+            piece_t start = {{type, 0}, engine.startingX, 0, 1};
+            if (!board_fits(&boards[b], start.x, start.y, shape_info(start.shape))) continue;
+            reach_search(&reach, &boards[b], &start);
+
+            for (unsigned int state = 0; state < REACH_STATES; state++) {
+                if (!reach_has(reach.landed, state)) continue;
+
+                input_t path[REACH_MAX_PATH];
+                int len = reach_path(&reach, state, path);
+                engine.board = boards[b];
+                engine.curr = start;
+                for (int i = 0; i < len; i++) {
+                    event_t events[ENGINE_MAX_EVENTS];
+                    if (engine_step(&engine, path[i], events) != 1) len = -1;
+                }
+
+                int o, x, y;
+                reach_unpack(state, &o, &x, &y);
+                shape_t shape = {type, o};
+                if (len < 0 || engine.curr.shape.orientation != o || engine.curr.x != x || engine.curr.y != y ||
+                    board_fits(&boards[b], x, y + 1, shape_info(shape))) {
+                    printf("reach: path does not lead to its landing\n");
+                    exit(1);
+                }
+                tucks += board_drop_row(&boards[b], x, 0, shape_info(shape)) != y;
+            }
+
+            for (int o = 0; o < NUM_ORIENTATIONS; o++) {
+                shape_t shape = {type, o};
+                const shape_info_t *info = shape_info(shape);
+                if (!board_fits(&boards[b], start.x, 0, info)) break;
+                for (int step = -1; step <= 1; step += 2) {
+                    for (int x = start.x; board_fits(&boards[b], x, 0, info); x += step) {
+                        int y = board_drop_row(&boards[b], x, 0, info);
+                        if (!reach_has(reach.landed, reach_state(o, x, y))) {
+                            printf("reach: missed a straight drop\n");
+                            exit(1);
+                        }
+                        drops++;
+                    }
+                }
+            }
+        }
+    }
+    printf("%-12s %-30s %12.0f tucks per 100 drops\n", "reach", "extra landings", 100 * tucks / drops);
+
+    double states = 0, landings = 0;
+    double start = now();
+    for (int r = 0; r < REACH_ROUNDS; r++) {
+        piece_t piece = {{r % NUM_SHAPES, 0}, engine.startingX, 0, 1};
+        landings += reach_search(&reach, &boards[r % 64], &piece);
+        states += reach.expanded;
+    }
+    double seconds = now() - start;
+    report("reach", "states expanded", states, seconds, "states");
+    report("reach", "searches", REACH_ROUNDS, seconds, "searches");
+    sink = landings;
+}
+
+/* ------ BOT ----*/
+
+#define BOT_ROUNDS 20000
+#define BOT_GAMES 20
+#define BOT_PIECES 2000 // games still going after this many pieces are stopped
+
+/* Measures the board the slow way: places the shape on a copy, clears
+   rows through the board module and reads the skyline and cells. */
+static void reference_features(const board_t *board, int x, int y, const shape_info_t *shape, bot_features_t *f) {
+    board_t after = *board;
+    unsigned int cleared;
+
+    board_place(&after, x, y, shape, 0);
+    f->lines = board_clear_rows(&after, y, &cleared);
+    f->height = f->holes = f->bumpiness = 0;
+
+    for (int c = 0; c < NUM_COLS; c++) {
+        f->height += after.height[c];
+        if (c > 0) f->bumpiness += abs(after.height[c] - after.height[c - 1]);
+        for (int r = NUM_ROWS - after.height[c]; r < NUM_ROWS; r++) {
+            f->holes += !((after.rows[r] >> (c + BOARD_WALL)) & 1);
+        }
+    }
+}
+
+#define TT_BYTES (4 << 20)
+#define LOOKAHEAD_PIECES 300 // at depth 2, a fifth of that deeper
+
+/* Plays the same game with a bot looking 'depth' shapes ahead, with and
+   without a transposition table: the table must not change a single
+   decision, only make them faster. */
+static void bench_lookahead(void) {
+    static engine_t with, without;
+    static tt_entry_t memory[TT_BYTES / sizeof(tt_entry_t)];
+    static bot_t fast, slow;
+    const bot_weights_t weights = BOT_DEFAULT_WEIGHTS;
+    tt_t tt;
+    char name[40];
+
+    for (int depth = 2; depth <= 3; depth++) {
+        double seconds[2] = {0, 0}, nodes[2] = {0, 0};
+        tt_init(&tt, memory, sizeof(memory));
+        bot_init(&fast, &weights);
+        bot_lookahead(&fast, depth, &tt);
+        bot_init(&slow, &weights);
+        bot_lookahead(&slow, depth, 0);
+        engine_init(&with, PIECES_RANDOM);
+        engine_new_game(&with, 7);
+        engine_init(&without, PIECES_RANDOM);
+        engine_new_game(&without, 7);
+
+        // Plan each shape once from where it comes into play, then drop it where the plan says
+        while (!with.over && with.spawned < (depth == 2 ? LOOKAHEAD_PIECES : LOOKAHEAD_PIECES / 5)) {
+            double start = now();
+            nodes[0] += bot_plan(&fast, &with);
+            seconds[0] += now() - start;
+            start = now();
+            nodes[1] += bot_plan(&slow, &without);
+            seconds[1] += now() - start;
+
+            if (fast.target != slow.target) {
+                printf("bot: the transposition table changed a decision\n");
+                exit(1);
+            }
+
+            input_t path[REACH_MAX_PATH];
+            int len = reach_path(&fast.reach[0], fast.target, path);
+            for (int i = 0; i <= len; i++) {
+                event_t events[ENGINE_MAX_EVENTS];
+                input_t input = i < len ? path[i] : INPUT_GRAVITY;
+                engine_step(&with, input, events);
+                engine_step(&without, input, events);
+            }
+        }
+
+        double plans = with.spawned;
+        snprintf(name, sizeof(name), "depth %d, no table", depth);
+        report("bot", name, plans, seconds[1], "plans");
+        snprintf(name, sizeof(name), "depth %d, table", depth);
+        report("bot", name, plans, seconds[0], "plans");
+        snprintf(name, sizeof(name), "depth %d, table nodes", depth);
+        report("bot", name, nodes[0], seconds[0], "nodes");
+        printf("%-12s %-30s %11.1f%% hits, %llu stores, %llu replaced, %u rows\n", "bot", "table",
+               100.0 * tt.hits / (tt.hits + tt.misses), tt.stores, tt.replaced, with.rowscleared);
+    }
+}
+
+static void bench_bot(void) {
+    static engine_t engine;
+    static board_t boards[64];
+    const bot_weights_t weights = BOT_DEFAULT_WEIGHTS;
+    bot_t bot;
+
+    // Check the mask-only features against the board module
+    for (int i = 0; i < 20000; i++) {
+        board_t board;
+        random_board(&board, rand() % 12, 40 + rand() % 55);
+        for (int y = 0; y < NUM_ROWS; y++) { // no full rows are left lying around in a game
+            if (board.rows[y] == BOARD_FULL_ROW) set_cell(&board, rand() % NUM_COLS, y, 0);
+        }
+        board_rebuild(&board);
+        shape_t shape = {rand() % NUM_SHAPES, rand() % NUM_ORIENTATIONS};
+        const shape_info_t *info = shape_info(shape);
+        int x = rand() % (NUM_COLS + 3) - 3;
+        if (!board_fits(&board, x, 0, info)) continue;
+
+        bot_features_t fast, slow;
+        int y = board_drop_row(&board, x, 0, info);
+        bot_features(&board, x, y, info, &fast);
+        reference_features(&board, x, y, info, &slow);
+        if (memcmp(&fast, &slow, sizeof(fast)) != 0) {
+            printf("bot: features of a placement do not match the board\n");
+            exit(1);
+        }
+    }
+
+    for (int i = 0; i < 64; i++) {
+        random_board(&boards[i], rand() % 10, 60);
+    }
+
+    bot_init(&bot, &weights);
+    engine_init(&engine, PIECES_RANDOM);
+    double placements = 0;
+    double start = now();
+    for (int r = 0; r < BOT_ROUNDS; r++) {
+        engine.board = boards[r % 64];
+        engine.curr.shape.type = r % NUM_SHAPES;
+        placements += bot_plan(&bot, &engine);
+    }
+    double seconds = now() - start;
+    report("bot", "placements", placements, seconds, "placements");
+    report("bot", "plans", BOT_ROUNDS, seconds, "plans");
+
+    // Let it play: gravity after every fourth input
+    double pieces = 0, rows = 0;
+    start = now();
+    for (int g = 0; g < BOT_GAMES; g++) {
+        engine_new_game(&engine, g);
+        bot_init(&bot, &weights);
+        for (int step = 1; !engine.over && engine.spawned < BOT_PIECES; step++) {
+            event_t events[ENGINE_MAX_EVENTS];
+            engine_step(&engine, step % 5 ? bot_next_input(&bot, &engine) : INPUT_GRAVITY, events);
+        }
+        pieces += engine.spawned;
+        rows += engine.rowscleared;
+    }
+    report("bot", "pieces played", pieces, now() - start, "pieces");
+    printf("%-12s %-30s %12.1f rows/game\n", "bot", "score", rows / BOT_GAMES);
+
+    bench_lookahead();
+}
+
+/* ------ BEAM ----*/
+
+#define BEAM_NODES 512
+#define BEAM_PIECES 300 // per game, each planned once from where it comes into play
+#define BEAM_BUDGET_US 2000
+
+static double clock_base;
+
+static unsigned int clock_us(void) {
+    return (unsigned int)((now() - clock_base) * 1e6);
+}
+
+/* Plays a game with the beam planner, checking that every plan gives all
+   its nodes back. Returns how many plans ran over their budget by more
+   than a quarter. */
+static int beam_game(beam_t *beam, bot_t *bot, engine_t *engine, double *plans, double *nodes,
+                        double *seconds) {
+    const bot_weights_t weights = BOT_DEFAULT_WEIGHTS;
+    int late = 0;
+    clock_base = now();
+    engine_init(engine, PIECES_RANDOM);
+    engine_new_game(engine, 11);
+    bot_init(bot, &weights);
+    bot_beam(bot, beam);
+
+    while (!engine->over && engine->spawned < BEAM_PIECES) {
+        double start = now();
+        *nodes += bot_plan(bot, engine);
+        (*plans)++;
+        double took = now() - start;
+        *seconds += took;
+        late += beam->budget_us && took * 1e6 > beam->budget_us * 1.25;
+
+        int pooled = 0;
+        for (int n = beam->free_node; n >= 0; n = beam->nodes[n].next == BEAM_NO_NODE ? -1 : beam->nodes[n].next) {
+            pooled++;
+        }
+        if (pooled != beam->capacity) {
+            printf("beam: a plan kept %d of its nodes\n", beam->capacity - pooled);
+            exit(1);
+        }
+
+        // Follow the plan, then let gravity land the shape (a hidden one takes an extra step)
+        input_t path[REACH_MAX_PATH];
+        event_t events[ENGINE_MAX_EVENTS];
+        unsigned int spawned = engine->spawned;
+        int len = reach_path(&bot->reach[0], bot->target, path);
+        for (int i = 0; i < len; i++) {
+            engine_step(engine, path[i], events);
+        }
+        while (!engine->over && engine->spawned == spawned) {
+            engine_step(engine, INPUT_GRAVITY, events);
+        }
+    }
+    return late;
+}
+
+static void bench_beam(void) {
+    static const struct { int width, depth; } SIZES[] = {{1, 1}, {8, 3}, {32, 3}, {32, 5}, {128, 5}, {256, 7}};
+    static beam_node_t nodes[BEAM_NODES];
+    static beam_t beam;
+    static engine_t engine;
+    static bot_t bot;
+    char name[40];
+
+    for (unsigned int i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); i++) {
+        double plans = 0, count = 0, seconds = 0;
+        beam_init(&beam, nodes, BEAM_NODES, SIZES[i].width, SIZES[i].depth);
+        beam_game(&beam, &bot, &engine, &plans, &count, &seconds);
+
+        snprintf(name, sizeof(name), "width %d, depth %d", beam.width, beam.depth);
+        report("beam", name, plans, seconds, "plans");
+        snprintf(name, sizeof(name), "width %d, depth %d nodes", beam.width, beam.depth);
+        report("beam", name, count, seconds, "nodes");
+        printf("%-12s %-30s %12u rows in %u pieces\n", "beam", "score", engine.rowscleared, engine.spawned);
+    }
+
+    // The widest and deepest search on a budget: plans have to stop close to it
+    double plans = 0, count = 0, seconds = 0;
+    beam_init(&beam, nodes, BEAM_NODES, BEAM_MAX_WIDTH, BEAM_MAX_DEPTH);
+    beam_budget(&beam, clock_us, BEAM_BUDGET_US);
+    int late = beam_game(&beam, &bot, &engine, &plans, &count, &seconds);
+    snprintf(name, sizeof(name), "budget %dus nodes", BEAM_BUDGET_US);
+    report("beam", name, count, seconds, "nodes");
+    printf("%-12s %-30s %12.0f us per plan, %d of %.0f late, %u rows\n", "beam", "budget",
+           seconds * 1e6 / plans, late, plans, engine.rowscleared);
+    if (late > plans / 20) { // a few can be late when the host is busy
+        printf("beam: plans ran over their budget\n");
+        exit(1);
+    }
+}
+
+/* ------ BATCH ----*/
+
+#define BATCH_BOARDS 4096
+#define BATCH_ROUNDS 200
+
+/* The same features, walking the placed blocks of one board cell by
+   cell as the renderer sees them. */
+static void walk_features(const board_t *board, unsigned short f[5]) {
+    int heights[NUM_COLS];
+    int holes = 0, transitions = 0, wells = 0;
+
+    for (int x = 0; x < NUM_COLS; x++) {
+        heights[x] = 0;
+        int depth = 0;
+        for (int y = 0; y < NUM_ROWS; y++) {
+            int filled = board_cell(board, x, y) != 0;
+            if (filled && heights[x] == 0) heights[x] = NUM_ROWS - y;
+            if (!filled && heights[x] > 0) holes++;
+
+            int left = x == 0 || board_cell(board, x - 1, y) != 0;
+            int right = x == NUM_COLS - 1 || board_cell(board, x + 1, y) != 0;
+            depth = !filled && left && right ? depth + 1 : 0;
+            wells += depth;
+        }
+    }
+    for (int y = 0; y < NUM_ROWS; y++) {
+        int last = 1; // the left wall
+        for (int x = 0; x <= NUM_COLS; x++) {
+            int filled = x == NUM_COLS || board_cell(board, x, y) != 0;
+            transitions += filled != last;
+            last = filled;
+        }
+    }
+
+    int height = heights[0], bumpiness = 0;
+    for (int x = 1; x < NUM_COLS; x++) {
+        height += heights[x];
+        bumpiness += abs(heights[x] - heights[x - 1]);
+    }
+    f[0] = height;
+    f[1] = holes;
+    f[2] = bumpiness;
+    f[3] = transitions;
+    f[4] = wells;
+}
+
+static void bench_batch(void) {
+    static board_t boards[BATCH_BOARDS];
+    static board_batch_t batches[BATCH_BOARDS / BATCH_MAX];
+    static batch_features_t features;
+    const batch_kernel_t *kernels;
+    int count = batch_kernels(&kernels);
+    char name[40];
+
+    // Half the boards as they are, half with a shape dropped in and its rows cleared
+    for (int i = 0; i < BATCH_BOARDS; i++) {
+        board_batch_t *batch = &batches[i / BATCH_MAX];
+        if (i % BATCH_MAX == 0) batch_clear(batch);
+        random_board(&boards[i], rand() % 14, 30 + rand() % 65);
+        for (int y = 0; y < NUM_ROWS; y++) {
+            if (boards[i].rows[y] == BOARD_FULL_ROW) set_cell(&boards[i], rand() % NUM_COLS, y, 0);
+        }
+        board_rebuild(&boards[i]);
+
+        shape_t shape = {rand() % NUM_SHAPES, rand() % NUM_ORIENTATIONS};
+        const shape_info_t *info = shape_info(shape);
+        int x = rand() % NUM_COLS - 1;
+        if (i % 2 && board_fits(&boards[i], x, 0, info)) {
+            int y = board_drop_row(&boards[i], x, 0, info);
+            unsigned int cleared;
+            batch_add_placement(batch, &boards[i], x, y, info);
+            board_place(&boards[i], x, y, info, shape.type);
+            if (board_clear_rows(&boards[i], y, &cleared) != batch->lines[batch->count - 1]) {
+                printf("batch: a placement cleared the wrong number of rows\n");
+                exit(1);
+            }
+        } else {
+            batch_add(batch, &boards[i]);
+        }
+    }
+
+    // Every kernel has to agree with the walk on every board
+    for (int k = 0; k < count; k++) {
+        for (int i = 0; i < BATCH_BOARDS; i++) {
+            int b = i % BATCH_MAX;
+            if (b == 0) kernels[k].run(&batches[i / BATCH_MAX], &features);
+
+            unsigned short slow[5];
+            unsigned short fast[5] = {features.height[b], features.holes[b], features.bumpiness[b],
+                                      features.transitions[b], features.wells[b]};
+            walk_features(&boards[i], slow);
+            if (memcmp(fast, slow, sizeof(fast)) != 0) {
+                printf("batch: the %s kernel does not match the walk\n", kernels[k].name);
+                exit(1);
+            }
+        }
+    }
+
+    double start = now();
+    for (int r = 0; r < BATCH_ROUNDS / 10; r++) {
+        for (int i = 0; i < BATCH_BOARDS; i++) {
+            unsigned short f[5];
+            walk_features(&boards[i], f);
+            sink += f[0] + f[4];
+        }
+    }
+    report("batch", "walk", (double)BATCH_ROUNDS / 10 * BATCH_BOARDS, now() - start, "boards");
+
+    for (int k = 0; k < count; k++) {
+        start = now();
+        for (int r = 0; r < BATCH_ROUNDS; r++) {
+            for (int i = 0; i < BATCH_BOARDS / BATCH_MAX; i++) {
+                kernels[k].run(&batches[i], &features);
+                sink += features.height[r % BATCH_MAX];
+            }
+        }
+        snprintf(name, sizeof(name), "%s, %d lanes", kernels[k].name, kernels[k].lanes);
+        report("batch", name, (double)BATCH_ROUNDS * BATCH_BOARDS, now() - start, "boards");
+    }
+}
+
+/* ------ RENDER ----*/
+
+#define RENDER_GAMES 50
+#define RENDER_STEPS 1000 // at most, per game
+#define RENDER_BLOCK 50 // the Pi's layout, see mymodule.c
+#define RENDER_LEFT (4*RENDER_BLOCK + 100)
+#define RENDER_TOP 20
+
+static const color_t RENDER_COLORS[NUM_SHAPES] = {GL_CYAN, GL_MAGENTA, GL_ORANGE, GL_YELLOW, GL_RED, GL_PURPLE, GL_GREEN};
+
+/* The drawing the renderer replaced: every block of a move drawn into
+   one buffer, swapped and drawn again into the other. */
+static void cell_draw_once(int x, int y, int cell) {
+    int left = RENDER_LEFT + x*RENDER_BLOCK, top = RENDER_TOP + y*RENDER_BLOCK;
+    if (x < 0 || x >= NUM_COLS || y < 0 || y >= NUM_ROWS) return;
+
+    if (cell == RENDER_EMPTY) {
+        gl_draw_rect(left, top, RENDER_BLOCK, RENDER_BLOCK, GL_WHITE);
+        return;
+    }
+    gl_draw_rect(left, top, RENDER_BLOCK, RENDER_BLOCK, RENDER_COLORS[cell - 1]);
+    gl_draw_rect(left, top, 1, RENDER_BLOCK, GL_BLACK);
+    gl_draw_rect(left + RENDER_BLOCK - 1, top, 1, RENDER_BLOCK, GL_BLACK);
+    gl_draw_rect(left, top, RENDER_BLOCK, 1, GL_BLACK);
+    gl_draw_rect(left, top + RENDER_BLOCK - 1, RENDER_BLOCK, 1, GL_BLACK);
+}
+
+static void cell_shape(const piece_t *at, int cell) {
+    const shape_info_t *info = shape_info(at->shape);
+    for (int i = 0; i < SHAPE_CELLS; i++) {
+        cell_draw_once(at->x + info->cells[i].x, at->y + info->cells[i].y, cell);
+        gl_swap_buffer();
+        cell_draw_once(at->x + info->cells[i].x, at->y + info->cells[i].y, cell);
+    }
+}
+
+/* Swaps and copies the whole new display buffer into the draw buffer,
+   counting the copy as pixels written. */
+static void cell_refresh(void) {
+    color_t *display = fb_get_draw_buffer();
+    gl_swap_buffer();
+    memcpy(fb_get_draw_buffer(), display, fb_get_pitch() * fb_get_height());
+    softfb_stats.pixels += fb_get_width() * fb_get_height();
+}
+
+static void cell_events(const engine_t *engine, const event_t *events, int count) {
+    for (int i = 0; i < count; i++) {
+        const event_t *event = &events[i];
+        if (event->type == EVENT_MOVED) {
+            if (event->from.visible) cell_shape(&event->from, RENDER_EMPTY);
+            if (event->to.visible) cell_shape(&event->to, event->to.shape.type + 1);
+        } else if (event->type == EVENT_CLEARED) {
+            int lowest = 0;
+            for (int y = 0; y < NUM_ROWS; y++) {
+                if (event->cleared & (1u << y)) {
+                    gl_draw_rect(RENDER_LEFT, RENDER_TOP + y*RENDER_BLOCK, NUM_COLS*RENDER_BLOCK, RENDER_BLOCK, GL_WHITE);
+                    lowest = y;
+                }
+            }
+            cell_refresh();
+            gl_draw_rect(RENDER_LEFT, RENDER_TOP, NUM_COLS*RENDER_BLOCK, (lowest + 1)*RENDER_BLOCK, GL_WHITE);
+            for (int x = 0; x < NUM_COLS; x++) {
+                for (int y = 0; y <= lowest; y++) {
+                    if (board_cell(&engine->board, x, y)) cell_draw_once(x, y, board_cell(&engine->board, x, y));
+                }
+            }
+            cell_refresh();
+        }
+    }
+}
+
+/* The same events through the renderer, as draw_events() does it. */
+static void frame_events(render_t *render, const engine_t *engine, const event_t *events, int count) {
+    for (int i = 0; i < count; i++) {
+        const event_t *event = &events[i];
+        if (event->type == EVENT_MOVED) {
+            if (event->from.visible) render_shape(render, event->from.x, event->from.y, event->from.shape, RENDER_EMPTY);
+            if (event->to.visible) {
+                render_shape(render, event->to.x, event->to.y, event->to.shape, event->to.shape.type + 1);
+            }
+        } else if (event->type == EVENT_CLEARED) {
+            for (int y = 0; y < NUM_ROWS; y++) {
+                if (event->cleared & (1u << y)) {
+                    for (int x = 0; x < NUM_COLS; x++) {
+                        render_cell(render, x, y, RENDER_EMPTY);
+                    }
+                }
+            }
+            render_frame(render);
+            render_clear_rows(render, event->cleared);
+        }
+    }
+    render_frame(render);
+}
+
+/* Plays one game drawn either way from a blank screen. Returns the
+   moves drawn and adds up the time spent drawing. */
+static double render_game(render_t *render, engine_t *engine, int game, double *seconds) {
+    unsigned int seed = game * 2654435761u + 1;
+    double moves = 0;
+
+    gl_init(NUM_COLS*RENDER_BLOCK + 2*RENDER_LEFT, NUM_ROWS*RENDER_BLOCK + 2*RENDER_TOP, GL_DOUBLEBUFFER);
+    gl_clear(GL_WHITE);
+    gl_swap_buffer();
+    gl_clear(GL_WHITE);
+    if (render) render_init(render, RENDER_LEFT, RENDER_TOP, RENDER_BLOCK, GL_WHITE, RENDER_COLORS);
+    softfb_stats_t none = {0};
+    softfb_stats = none;
+
+    engine_new_game(engine, game);
+    for (int tick = 0; !engine->over && tick < RENDER_STEPS; tick++) {
+        event_t events[ENGINE_MAX_EVENTS];
+        seed = seed * 1103515245 + 12345;
+        input_t input = (tick % 11 == 10) ? INPUT_GRAVITY : (input_t)(INPUT_LEFT + (seed >> 16) % 4);
+        int count = engine_step(engine, input, events);
+        for (int i = 0; i < count; i++) {
+            moves += events[i].type == EVENT_MOVED;
+        }
+
+        double start = now();
+        if (render) frame_events(render, engine, events, count);
+        else cell_events(engine, events, count);
+        *seconds += now() - start;
+    }
+    if (render) render_frame(render); // the back buffer catches up without a swap
+    return moves;
+}
+
+static void bench_render(void) {
+    static engine_t engine;
+    static render_t render;
+    static color_t *screens[2];
+    const char *names[2] = {"per-cell swaps", "frame batched"};
+    double moves[2] = {0}, seconds[2] = {0}, swaps[2] = {0}, pixels[2] = {0};
+    engine_init(&engine, PIECES_RANDOM);
+
+    for (int game = 0; game < RENDER_GAMES; game++) {
+        for (int way = 0; way < 2; way++) {
+            moves[way] += render_game(way ? &render : NULL, &engine, game, &seconds[way]);
+            swaps[way] += softfb_stats.swaps;
+            pixels[way] += softfb_stats.pixels + (way ? render.stats.pixels + render.stats.scrolled : 0); // tiles are blitted past gl
+
+            size_t bytes = fb_get_pitch() * fb_get_height();
+            screens[way] = realloc(screens[way], 2 * bytes);
+            memcpy(screens[way], softfb_display_buffer(), bytes);
+            memcpy((char *)screens[way] + bytes, fb_get_draw_buffer(), bytes);
+            if (way && memcmp(screens[0], screens[1], 2 * bytes) != 0) {
+                printf("render: the frames do not match the per-cell drawing\n");
+                exit(1);
+            }
+        }
+        if (render.stats.swaps != softfb_stats.swaps || render.stats.pixels != render.stats.cells * RENDER_BLOCK * RENDER_BLOCK) {
+            printf("render: the counters do not match the framebuffer\n");
+            exit(1);
+        }
+    }
+
+    for (int way = 0; way < 2; way++) {
+        report("render", names[way], moves[way], seconds[way], "moves");
+        printf("%-12s %-30s %12.2f swaps, %.0f pixels per move\n", "render", names[way],
+               swaps[way] / moves[way], pixels[way] / moves[way]);
+    }
+}
+
+/* ------ REFRESH ----*/
+
+#define REFRESH_GAMES 20
+#define REFRESH_CHAR_WIDTH 14 // the Pi's gl font
+#define REFRESH_CHAR_HEIGHT 16
+
+/* Swaps the buffers and brings the new draw buffer up to date, copying
+   either the whole screen or only what it missed, as screen_refresh()
+   does with the playfield's frame drawn first. Returns the bytes copied. */
+static double refresh_screen(damage_t *damage, render_t *render) {
+    render_draw(render);
+    char *display = fb_get_draw_buffer();
+    gl_swap_buffer();
+    char *draw = fb_get_draw_buffer();
+    int pitch = fb_get_pitch(), depth = fb_get_depth();
+
+    if (!damage) {
+        memcpy(draw, display, pitch * fb_get_height());
+        return pitch * fb_get_height();
+    }
+
+    damage_rect_t rects[DAMAGE_MAX_RECTS];
+    int count = damage_take(damage, draw, rects);
+    double bytes = 0;
+    for (int i = 0; i < count; i++) {
+        int offset = rects[i].y*pitch + rects[i].x*depth;
+        span_copy_rect((color_t *)(draw + offset), pitch / depth, (const color_t *)(display + offset), pitch / depth,
+                       rects[i].w, rects[i].h);
+        bytes += (double)rects[i].w * rects[i].h * depth;
+    }
+    return bytes;
+}
+
+/* Draws a rectangle and records it as damage, as screen_drawn() does. */
+static void refresh_rect(damage_t *damage, int x, int y, int w, int h, color_t color) {
+    gl_draw_rect(x, y, w, h, color);
+    if (damage) damage_add(damage, fb_get_draw_buffer(), x, y, w, h);
+}
+
+/* Fails unless the back buffer, once the renderer has let it catch up,
+   shows the same as the screen: nothing drawn may be left out of either. */
+static void refresh_check(render_t *render, int game, int tick) {
+    render_frame(render); // no cell changed since the last frame, so this does not swap
+    if (memcmp(fb_get_draw_buffer(), softfb_display_buffer(), fb_get_pitch() * fb_get_height()) != 0) {
+        printf("refresh: the buffers differ in game %d at step %d\n", game, tick);
+        exit(1);
+    }
+}
+
+/* Plays a game drawing the screen in the order mymodule.c does, from
+   two buffers still showing different screens: all of it with the empty
+   board at the start, the playfield a frame at a time, the preview box
+   when a shape comes into play and the score when rows clear, each of
+   those followed by a refresh. */
+static void refresh_game(damage_t *damage, render_t *render, engine_t *engine, int game, double refreshes[2],
+                         double bytes[2], double *seconds) {
+    int width = NUM_COLS*RENDER_BLOCK + 2*RENDER_LEFT, height = NUM_ROWS*RENDER_BLOCK + 2*RENDER_TOP;
+    int score_x = RENDER_LEFT + NUM_COLS*RENDER_BLOCK + 55, score_y = RENDER_TOP + REFRESH_CHAR_HEIGHT + 3;
+    int box_x = score_x + 5, box_y = height/2 - RENDER_BLOCK*2 + 5;
+
+    // The title or loss screen in one buffer and whatever came before in the other
+    gl_init(width, height, GL_DOUBLEBUFFER);
+    gl_clear(GL_BLACK);
+    gl_swap_buffer();
+    gl_clear(GL_RED);
+    if (damage) damage_init(damage, width, height);
+    render_init(render, RENDER_LEFT, RENDER_TOP, RENDER_BLOCK, GL_WHITE, RENDER_COLORS);
+    engine_new_game(engine, game);
+
+    // background_init()
+    double start = now();
+    refresh_rect(damage, 0, 0, width, height, GL_WHITE);
+    render_reset(render, &engine->board);
+    bytes[0] += refresh_screen(damage, render);
+    refreshes[0]++;
+    *seconds += now() - start;
+
+    for (int tick = 0; !engine->over; tick++) {
+        event_t events[ENGINE_MAX_EVENTS];
+        input_t input = (tick % 11 == 10) ? INPUT_GRAVITY : (input_t)(INPUT_LEFT + (tick * 7 + game) % 4);
+        int count = engine_step(engine, input, events);
+        int refreshed = 0;
+
+        // draw_events()
+        start = now();
+        for (int i = 0; i < count; i++) {
+            const event_t *event = &events[i];
+            if (event->type == EVENT_MOVED) {
+                if (event->from.visible) render_shape(render, event->from.x, event->from.y, event->from.shape, RENDER_EMPTY);
+                if (event->to.visible) {
+                    render_shape(render, event->to.x, event->to.y, event->to.shape, event->to.shape.type + 1);
+                }
+            } else if (event->type == EVENT_SPAWNED) {
+                const shape_info_t *info = shape_info(engine->next);
+                refresh_rect(damage, box_x, box_y, RENDER_BLOCK*4, RENDER_BLOCK*4, GL_WHITE);
+                for (int c = 0; c < SHAPE_CELLS; c++) {
+                    gl_draw_rect(box_x + info->cells[c].x*RENDER_BLOCK, box_y + 5 + (info->cells[c].y + 1)*RENDER_BLOCK,
+                                 RENDER_BLOCK, RENDER_BLOCK, RENDER_COLORS[engine->next.type]);
+                }
+                if (damage) {
+                    damage_add(damage, fb_get_draw_buffer(), box_x + info->left*RENDER_BLOCK,
+                               box_y + 5 + (info->top + 1)*RENDER_BLOCK, (info->right - info->left + 1)*RENDER_BLOCK,
+                               (info->bottom - info->top + 1)*RENDER_BLOCK);
+                }
+                bytes[1] += refresh_screen(damage, render);
+                refreshes[1]++;
+                refreshed = 1;
+            } else if (event->type == EVENT_CLEARED) {
+                refresh_rect(damage, score_x, score_y, REFRESH_CHAR_WIDTH*5, REFRESH_CHAR_HEIGHT, GL_WHITE);
+                refresh_rect(damage, score_x, score_y, REFRESH_CHAR_WIDTH * (engine->rowscleared % 5 + 1),
+                             REFRESH_CHAR_HEIGHT / 2, GL_BLACK);
+                bytes[1] += refresh_screen(damage, render);
+                refreshes[1]++;
+                refreshed = 1;
+
+                for (int y = 0; y < NUM_ROWS; y++) {
+                    for (int x = 0; x < NUM_COLS && (event->cleared & (1u << y)); x++) {
+                        render_cell(render, x, y, RENDER_EMPTY);
+                    }
+                }
+                render_frame(render);
+                render_clear_rows(render, event->cleared);
+                render_frame(render);
+            }
+        }
+        render_frame(render);
+        *seconds += now() - start;
+
+        // Checking every step would take longer than the game, and what a
+        // refresh leaves out stays out until the next one anyway
+        if (refreshed || tick == 0) refresh_check(render, game, tick);
+    }
+    refresh_check(render, game, -1);
+}
+
+static void bench_refresh(void) {
+    static engine_t engine;
+    static damage_t damage;
+    static render_t render;
+    const char *names[2] = {"full copy", "damaged regions"};
+    double refreshes[2][2] = {{0}}, bytes[2][2] = {{0}}, seconds[2] = {0};
+    engine_init(&engine, PIECES_RANDOM);
+
+    for (int game = 0; game < REFRESH_GAMES; game++) {
+        for (int way = 0; way < 2; way++) {
+            refresh_game(way ? &damage : NULL, &render, &engine, game, refreshes[way], bytes[way], &seconds[way]);
+        }
+    }
+
+    for (int way = 0; way < 2; way++) {
+        double all = refreshes[way][0] + refreshes[way][1];
+        report("refresh", names[way], all, seconds[way], "refreshes");
+        printf("%-12s %-30s %12.0f bytes per refresh, %.0f during play\n", "refresh", names[way],
+               (bytes[way][0] + bytes[way][1]) / all, bytes[way][1] / refreshes[way][1]);
+    }
+}
+
+/* ------ TILES ----*/
+
+#define TILE_BLITS 200000
+
+/* Draws a block the way draw_square_with_bound() did without tiles: the
+   fill, then an outline of 'border' pixels around it. */
+static void rect_square(int x, int y, int size, int border, color_t color) {
+    gl_draw_rect(x, y, size, size, color);
+    gl_draw_rect(x, y, border, size, GL_BLACK);
+    gl_draw_rect(x + size - border, y, border, size, GL_BLACK);
+    gl_draw_rect(x, y, size, border, GL_BLACK);
+    gl_draw_rect(x, y + size - border, size, border, GL_BLACK);
+}
+
+static void bench_tiles(void) {
+    static tile_t tiles[2 * NUM_SHAPES + 1];
+    static color_t *screen;
+    int width = NUM_COLS*RENDER_BLOCK + 2*RENDER_LEFT, height = NUM_ROWS*RENDER_BLOCK + 2*RENDER_TOP;
+    size_t bytes = (size_t)width * height * sizeof(color_t);
+    char name[40];
+
+    // Playfield blocks, title blocks and the background, as mymodule.c has them
+    for (int type = 0; type < NUM_SHAPES; type++) {
+        tile_square(&tiles[type], RENDER_BLOCK, 1, RENDER_COLORS[type]);
+        tile_square(&tiles[NUM_SHAPES + type], RENDER_BLOCK, 2, RENDER_COLORS[type]);
+    }
+    tile_square(&tiles[2 * NUM_SHAPES], RENDER_BLOCK, 0, GL_WHITE);
+
+    // The same blocks at the same spots both ways, some of them off the
+    // edges of the screen, have to leave the same pixels
+    gl_init(width, height, GL_SINGLEBUFFER);
+    screen = realloc(screen, bytes);
+    for (int way = 0; way < 2; way++) {
+        srand(23);
+        gl_clear(GL_BLACK);
+        softfb_stats_t none = {0};
+        softfb_stats = none;
+
+        double pixels = 0, start = now();
+        for (int i = 0; i < TILE_BLITS; i++) {
+            int t = rand() % (2 * NUM_SHAPES + 1);
+            int x = rand() % (width + RENDER_BLOCK) - RENDER_BLOCK;
+            int y = rand() % (height + RENDER_BLOCK) - RENDER_BLOCK;
+            if (way) {
+                pixels += tile_blit(&tiles[t], x, y);
+            } else {
+                rect_square(x, y, RENDER_BLOCK, t < 2 * NUM_SHAPES ? 1 + t / NUM_SHAPES : 0, tiles[t].fill);
+            }
+        }
+        double seconds = now() - start;
+        pixels += softfb_stats.pixels;
+
+        snprintf(name, sizeof(name), "%s, %d px", way ? "tile blit" : "five rects", RENDER_BLOCK);
+        report("tiles", name, TILE_BLITS, seconds, "blocks");
+        report("tiles", name, pixels, seconds, "pixels");
+        printf("%-12s %-30s %12.0f pixels written per block\n", "tiles", name, pixels / TILE_BLITS);
+
+        if (!way) {
+            memcpy(screen, fb_get_draw_buffer(), bytes);
+        } else if (memcmp(screen, fb_get_draw_buffer(), bytes) != 0) {
+            printf("tiles: the blits do not match the rectangles\n");
+            exit(1);
+        }
+    }
+}
+
+/* ------ SPAN ----*/
+
+#define SPAN_AREA 2048 // pixels, more than a screen row
+#define SPAN_GUARD 16 // pixels on either side that must not change
+#define SPAN_ROWS 16 // per rectangle in the measurements
+#define SPAN_PIXELS 40000000 // per measurement
+
+static void bench_span(void) {
+    static const int WIDTHS[] = {50, 200, 1100}; // a block, the preview box, a screen row
+    static const int CHECK_WIDTHS[] = {0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 50, 200, 1100};
+    static color_t to[SPAN_ROWS * SPAN_AREA] __attribute__((aligned(64)));
+    static color_t from[SPAN_ROWS * SPAN_AREA] __attribute__((aligned(64)));
+    static color_t want[SPAN_AREA];
+    const span_kernel_t *kernels;
+    int count = span_kernels(&kernels);
+    char name[40];
+
+    for (int i = 0; i < SPAN_ROWS * SPAN_AREA; i++) {
+        from[i] = 0xFF000000 | (i * 2654435761u >> 8);
+    }
+
+    // Every kernel at every start within 32 bytes, from every source
+    // alignment, against writing one pixel at a time
+    for (int k = 0; k < count; k++) {
+        for (unsigned int w = 0; w < sizeof(CHECK_WIDTHS) / sizeof(CHECK_WIDTHS[0]); w++) {
+            for (int offset = 0; offset < 8; offset++) {
+                for (int source = 0; source < 8; source++) {
+                    int width = CHECK_WIDTHS[w], start = SPAN_GUARD + offset;
+                    for (int copy = 0; copy < 2; copy++) {
+                        for (int i = 0; i < SPAN_AREA; i++) {
+                            to[i] = want[i] = GL_BLACK;
+                        }
+                        for (int i = 0; i < width; i++) {
+                            want[start + i] = copy ? from[source + i] : GL_CYAN;
+                        }
+                        if (copy) kernels[k].copy(to + start, 0, from + source, 0, width, 1);
+                        else kernels[k].fill(to + start, 0, width, 1, GL_CYAN);
+                        if (memcmp(to, want, sizeof(want)) != 0) {
+                            printf("span: the %s %s of %d pixels at +%d is wrong\n", kernels[k].name,
+                                   copy ? "copy" : "fill", width, offset);
+                            exit(1);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Pixels per second for each kernel, filling or copying rectangles of
+    // SPAN_ROWS rows that start 64-byte aligned or one pixel past that
+    for (int copy = 0; copy < 2; copy++) {
+        for (unsigned int w = 0; w < sizeof(WIDTHS) / sizeof(WIDTHS[0]); w++) {
+            for (int offset = 0; offset < 2; offset++) {
+                int width = WIDTHS[w], rounds = SPAN_PIXELS / (width * SPAN_ROWS);
+                snprintf(name, sizeof(name), "%s %d px at +%d", copy ? "copy" : "fill", width, offset);
+                printf("%-12s %-30s", "span", name);
+                for (int k = 0; k < count; k++) {
+                    double start = now();
+                    for (int r = 0; r < rounds; r++) {
+                        if (copy) kernels[k].copy(to + offset, SPAN_AREA, from + offset + (r & 1), SPAN_AREA, width, SPAN_ROWS);
+                        else kernels[k].fill(to + offset, SPAN_AREA, width, SPAN_ROWS, (color_t)r);
+                    }
+                    sink += to[offset + width / 2];
+                    double pixels = (double)rounds * width * SPAN_ROWS;
+                    printf(" %s %5.0f", kernels[k].name, pixels / (now() - start) / 1e6);
+                }
+                printf(" Mpixels/sec\n");
+            }
+        }
+    }
+}
+
+/* ------ CLEAR ----*/
+
+#define CLEAR_BOARDS 300
+
+/* Redraws a line clear the renderer's way before it could scroll: every
+   cell above the lowest cleared row that changed is drawn again. */
+static void redraw_cleared(render_t *render, const board_t *after, unsigned int cleared) {
+    int lowest = 0;
+    for (int y = 0; y < NUM_ROWS; y++) {
+        if (cleared & (1u << y)) lowest = y;
+    }
+    for (int x = 0; x < NUM_COLS; x++) {
+        for (int y = 0; y <= lowest; y++) {
+            render_cell(render, x, y, board_cell(after, x, y));
+        }
+    }
+}
+
+static void bench_clear(void) {
+    static engine_t engine;
+    static render_t render;
+    static board_t before;
+    static color_t *screens;
+    const char *names[3] = {"per-cell redraw", "changed cells", "scroll"};
+    double seconds[3] = {0}, pixels[3] = {0}, clears[3] = {0};
+    int width = NUM_COLS*RENDER_BLOCK + 2*RENDER_LEFT, height = NUM_ROWS*RENDER_BLOCK + 2*RENDER_TOP;
+    char name[40];
+
+    gl_init(width, height, GL_DOUBLEBUFFER);
+    render_init(&render, RENDER_LEFT, RENDER_TOP, RENDER_BLOCK, GL_WHITE, RENDER_COLORS);
+    size_t bytes = fb_get_pitch() * fb_get_height();
+    screens = realloc(screens, 2 * bytes);
+
+    // Stacks of every height on top of four full rows, and for every other
+    // board only some of the four full so rows in between move less
+    for (int i = 0; i < CLEAR_BOARDS; i++) {
+        int four = i % 2 == 0;
+        unsigned int full = four ? 0xF : 1 + rand() % 15;
+        random_board(&before, 4 + rand() % (NUM_ROWS - 5), 60);
+        for (int y = 0; y < NUM_ROWS; y++) {
+            int bottom = y - (NUM_ROWS - 4);
+            for (int x = 0; x < NUM_COLS; x++) {
+                if (bottom >= 0 && (full >> bottom & 1) && !board_cell(&before, x, y)) set_cell(&before, x, y, rand() % 7 + 1);
+            }
+            if (bottom >= 0 && !(full >> bottom & 1)) set_cell(&before, rand() % NUM_COLS, y, 0);
+            else if (bottom < 0 && before.rows[y] == BOARD_FULL_ROW) set_cell(&before, rand() % NUM_COLS, y, 0);
+        }
+        board_rebuild(&before);
+        engine.board = before;
+        unsigned int cleared;
+        board_clear_rows(&engine.board, NUM_ROWS - 4, &cleared);
+
+        for (int way = 0; way < 3; way++) {
+            // Both buffers start out showing the board
+            for (int buffer = 0; buffer < 2; buffer++) {
+                gl_draw_rect(RENDER_LEFT, RENDER_TOP, NUM_COLS*RENDER_BLOCK, NUM_ROWS*RENDER_BLOCK, GL_WHITE);
+                for (int y = 0; y < NUM_ROWS; y++) {
+                    for (int x = 0; x < NUM_COLS; x++) {
+                        cell_draw_once(x, y, board_cell(&before, x, y));
+                    }
+                }
+                gl_swap_buffer();
+            }
+            render_reset(&render, &before);
+            softfb_stats_t none = {0};
+            softfb_stats = none;
+            render.stats.pixels = render.stats.scrolled = 0;
+
+            // The clear as draw_cleared_rows() does it, and the other buffer caught up after
+            double start = now();
+            if (way == 0) {
+                event_t event = {EVENT_CLEARED};
+                event.cleared = cleared;
+                cell_events(&engine, &event, 1);
+            } else {
+                for (int y = 0; y < NUM_ROWS; y++) {
+                    for (int x = 0; x < NUM_COLS && (cleared & (1u << y)); x++) {
+                        render_cell(&render, x, y, RENDER_EMPTY);
+                    }
+                }
+                render_frame(&render);
+                if (way == 1) redraw_cleared(&render, &engine.board, cleared);
+                else render_clear_rows(&render, cleared);
+                render_frame(&render);
+                render_frame(&render);
+            }
+            if (four) {
+                seconds[way] += now() - start;
+                pixels[way] += softfb_stats.pixels + render.stats.pixels + render.stats.scrolled;
+                clears[way]++;
+            }
+
+            if (way == 0) {
+                memcpy(screens, softfb_display_buffer(), bytes);
+                memcpy((char *)screens + bytes, fb_get_draw_buffer(), bytes);
+            } else if (memcmp(screens, softfb_display_buffer(), bytes) != 0 ||
+                       memcmp((char *)screens + bytes, fb_get_draw_buffer(), bytes) != 0) {
+                printf("clear: %s leaves different pixels than redrawing every cell\n", names[way]);
+                exit(1);
+            }
+        }
+    }
+
+    for (int way = 0; way < 3; way++) {
+        snprintf(name, sizeof(name), "%s, 4 rows", names[way]);
+        report("clear", name, clears[way], seconds[way], "clears");
+        printf("%-12s %-30s %12.1f us, %.0f pixels per clear\n", "clear", name,
+               seconds[way] * 1e6 / clears[way], pixels[way] / clears[way]);
+    }
+}
+
+/* ------ DRIVER ----*/
+
+static const struct {
+    const char *name;
+    void (*run)(void);
+} SUITES[] = {
+    {"collision", bench_collision},
+    {"lineclear", bench_lineclear},
+    {"skyline", bench_skyline},
+    {"engine", bench_engine},
+    {"pieces", bench_pieces},
+    {"snapshot", bench_snapshot},
+    {"hash", bench_hash},
+    {"reach", bench_reach},
+    {"bot", bench_bot},
+    {"beam", bench_beam},
+    {"batch", bench_batch},
+    {"render", bench_render},
+    {"refresh", bench_refresh},
+    {"tiles", bench_tiles},
+    {"span", bench_span},
+    {"clear", bench_clear},
+};
+
+#define NUM_SUITES (sizeof(SUITES) / sizeof(SUITES[0]))
+
+int main(int argc, char *argv[]) {
+    srand(107);
+    printf("%-12s %-30s %12d x %d\n", "board", "geometry", NUM_COLS, NUM_ROWS);
+
+    for (int i = 0; i < NUM_SUITES; i++) {
+        int selected = (argc == 1);
+        for (int arg = 1; arg < argc; arg++) {
+            if (strcmp(argv[arg], SUITES[i].name) == 0) selected = 1;
+        }
+        if (selected) SUITES[i].run();
+    }
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+/* Generates shape_table.c from the SHAPE maps in shape_data.h.
+
+Prints the precompiled SHAPE_INFO table (row masks, filled cells,
+bounding box and profiles of every orientation) to stdout. Run through
+"make -C host table", which writes the result to ../shape_table.c.
+*/
+
+#include <stdio.h>
+#include "shape_data.h"
+
+static const char *NAMES = "IJLOSTZ";
+
+static void print_row(const char *field, const signed char values[4]) {
+    printf("        .%s = {%d, %d, %d, %d},\n", field, values[0], values[1], values[2], values[3]);
+}
+
+static int print_orientation(int type, int orientation) {
+    const char (*map)[4] = SHAPE[type][orientation];
+    int masks[4] = {0, 0, 0, 0};
+    int left = 3, right = 0, top = 3, bottom = 0;
+    signed char bottom_profile[4] = {-1, -1, -1, -1};
+    signed char left_profile[4] = {-1, -1, -1, -1};
+    signed char right_profile[4] = {-1, -1, -1, -1};
+
+    printf("    { // %c-shape, orientation %d\n", NAMES[type], orientation);
+    printf("        .cells = {");
+    int cells = 0;
+    for (int mapY = 0; mapY < 4; mapY++) {
+        for (int mapX = 0; mapX < 4; mapX++) {
+            if (map[mapY][mapX] != 1) continue;
+
+            printf("%s{%d, %d}", cells++ ? ", " : "", mapX, mapY);
+            masks[mapY] |= 1 << mapX;
+            if (mapX < left) left = mapX;
+            if (mapX > right) right = mapX;
+            if (mapY < top) top = mapY;
+            if (mapY > bottom) bottom = mapY;
+            bottom_profile[mapX] = mapY;
+            if (left_profile[mapY] < 0) left_profile[mapY] = mapX;
+            right_profile[mapY] = mapX;
+        }
+    }
+    printf("},\n");
+
+    printf("        .masks = {0x%x, 0x%x, 0x%x, 0x%x},\n", masks[0], masks[1], masks[2], masks[3]);
+    printf("        .left = %d, .right = %d, .top = %d, .bottom = %d,\n", left, right, top, bottom);
+    print_row("bottom_profile", bottom_profile);
+    print_row("left_profile", left_profile);
+    print_row("right_profile", right_profile);
+    printf("    },\n");
+
+    if (cells != 4) {
+        fprintf(stderr, "gen_shape_table: %c-shape orientation %d has %d cells\n", NAMES[type], orientation, cells);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    int status = 0;
+
+    printf("/* Generated by host/gen_shape_table.c from shape_data.h. Do not edit. */\n\n");
+    printf("#include \"shape_table.h\"\n\n");
+    printf("const shape_info_t SHAPE_INFO[NUM_SHAPES][NUM_ORIENTATIONS] = {\n");
+    for (int type = 0; type < 7; type++) {
+        printf("  {\n");
+        for (int orientation = 0; orientation < 4; orientation++) {
+            status |= print_orientation(type, orientation);
+        }
+        printf("  },\n");
+    }
+    printf("};\n");
+    return status;
+}
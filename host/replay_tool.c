@@ -0,0 +1,202 @@
+/* Plays back the games logged by the Pi at full speed.
+
+The Pi streams the replay log of every game over the UART as lines of
+the form "@replay <hex>", mixed in with its other output. Save that
+output to a file and run
+
+    ./host/replay capture.txt
+
+Every game in the capture is fed through the headless engine from its
+seed, its final state is compared against the snapshot that ends its
+log, and the replay speed is reported. Games that were left before they
+ended, like interrupted demos, are reported and skipped, and a log that
+was cut off does not take the ones after it down with it. "./replay -g <seed>" writes the
+log of a random game played on the host in the same format, which is
+handy for trying the tool without the glove rig.
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "engine.h"
+#include "replay.h"
+
+#define REPLAY_ROUNDS 200 // times each game is replayed when timing it
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Collects the bytes of every "@replay" line in the file. Returns the
+   number of bytes, or -1 if the file cannot be read. */
+static long read_capture(const char *path, unsigned char **bytes) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    long len = 0, cap = 4096;
+    *bytes = malloc(cap);
+    char line[1024];
+    int lineno = 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        lineno++;
+        char *hex = strstr(line, "@replay ");
+        if (hex == NULL) continue;
+
+        for (hex += 8; hex_digit(hex[0]) >= 0 && hex_digit(hex[1]) >= 0; hex += 2) {
+            if (len == cap) *bytes = realloc(*bytes, cap *= 2);
+            (*bytes)[len++] = hex_digit(hex[0]) << 4 | hex_digit(hex[1]);
+        }
+        if (*hex != '\n' && *hex != '\r' && *hex != '\0') {
+            fprintf(stderr, "%s:%d: replay line is torn or corrupt\n", path, lineno);
+        }
+    }
+
+    fclose(fp);
+    return len;
+}
+
+/* Replays one game from the log at 'reader'. Returns 1 if its final
+   state matches the log, 0 on a desync, -1 if the log is cut short or
+   malformed and -2 if the game was abandoned. Counts the inputs it fed
+   the engine in 'inputs'. */
+static int replay_game(replay_reader_t *reader, engine_t *engine, long *inputs) {
+    engine_init(engine, reader->mode);
+    engine_new_game(engine, reader->seed);
+    engine->mostrows = reader->mostrows;
+
+    for (*inputs = 0; ; (*inputs)++) {
+        input_t input;
+        unsigned int tick;
+        snapshot_t final, actual;
+        event_t events[ENGINE_MAX_EVENTS];
+
+        switch (replay_read(reader, &input, &tick, &final)) {
+        case REPLAY_INPUT:
+            engine_step(engine, input, events);
+            break;
+        case REPLAY_END:
+            snapshot_take(engine, &actual);
+            return memcmp(&final, &actual, sizeof(final)) == 0;
+        case REPLAY_ABORTED:
+            return -2;
+        default:
+            return -1;
+        }
+    }
+}
+
+static int check_capture(const char *path) {
+    unsigned char *bytes;
+    long len = read_capture(path, &bytes);
+    if (len < 0) {
+        fprintf(stderr, "replay: cannot read %s\n", path);
+        return 1;
+    }
+
+    static engine_t engine;
+    int games = 0, failures = 0;
+    long offset = 0;
+
+    while (offset < len) {
+        replay_reader_t reader;
+        if (replay_open(&reader, bytes + offset, len - offset) != REPLAY_INPUT) {
+            fprintf(stderr, "replay: no log header at byte %ld\n", offset);
+            failures++;
+            break;
+        }
+
+        replay_reader_t start = reader;
+        long inputs;
+        int result = replay_game(&reader, &engine, &inputs);
+        games++;
+
+        if (result == -2) {
+            printf("game %d: seed %u, abandoned after %ld inputs\n", games, start.seed, inputs);
+            offset = reader.p - bytes;
+            continue;
+        }
+        if (result < 0) {
+            printf("game %d: seed %u, log cut short after %ld inputs\n", games, start.seed, inputs);
+            failures++;
+            if (!replay_resync(&reader)) break;
+            offset = reader.p - bytes;
+            continue;
+        }
+
+        // Replay it again and again to see how fast the engine gets through it
+        double begin = now();
+        for (int r = 0; r < REPLAY_ROUNDS; r++) {
+            reader = start;
+            replay_game(&reader, &engine, &inputs);
+        }
+        double seconds = now() - begin;
+
+        printf("game %d: seed %u, %ld inputs over %u ticks, %u rows, board %016llx, %s, %.0f inputs/sec\n",
+               games, start.seed, inputs, reader.tick - start.tick, engine.rowscleared, engine.board.hash,
+               result ? "final board matches" : "DESYNC", inputs * REPLAY_ROUNDS / seconds);
+        if (!result) failures++;
+
+        offset = reader.p - bytes;
+    }
+
+    free(bytes);
+    printf("%d games, %d failed\n", games, failures);
+    return failures != 0;
+}
+
+/* Writes the log of a random game played on the host to stdout. */
+static void write_line(const unsigned char *bytes, int len) {
+    printf("@replay ");
+    for (int i = 0; i < len; i++) printf("%02x", bytes[i]);
+    printf("\n");
+}
+
+static int generate(unsigned int seed) {
+    static engine_t engine;
+    replay_writer_t writer;
+    rng_t rng;
+
+    engine_init(&engine, PIECES_RANDOM);
+    engine_new_game(&engine, seed);
+    rng_seed(&rng, seed);
+    replay_start(&writer, write_line, &engine, 0);
+
+    for (unsigned int tick = 0, n = 1; !engine.over; n++) {
+        event_t events[ENGINE_MAX_EVENTS];
+        input_t input = (n % 11 == 0) ? INPUT_GRAVITY : (input_t)(INPUT_LEFT + rng_below(&rng, 4));
+        tick += 1 + rng_below(&rng, 40);
+        replay_record(&writer, input, tick);
+        engine_step(&engine, input, events);
+    }
+
+    replay_finish(&writer, &engine);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 3 && strcmp(argv[1], "-g") == 0) {
+        return generate(strtoul(argv[2], NULL, 0));
+    }
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s capture.txt\n       %s -g seed > capture.txt\n", argv[0], argv[0]);
+        return 2;
+    }
+
+    return check_capture(argv[1]);
+}
@@ -0,0 +1,445 @@
+/* Batch simulator for the Tetris rules.
+
+Plays many independent games on the headless engine across all cores
+and reports how fast it went and how the games turned out, so the
+gravity schedule and the scoring rules can be tuned on real statistics
+rather than a few hand-played sessions.
+
+Games are timed the way the Pi runs them, from the constants in
+timing.h: the armtimer fires every 50 ms, gravity moves the shape every
+11th interrupt, and once 5 rows are cleared the armtimer is slowed to
+200 ms. The player is scripted:
+it picks a spot for each new shape, then rotates, slides and drops it
+there at a fixed input rate.
+
+    ./sim [-g games] [-t threads] [-b batch] [-p greedy|random|bot]
+          [-i input_ms] [-s speed_rows] [-f fast_ms] [-S slow_ms]
+          [-n max_pieces] [-m bag] [-x seed] [-d depth] [-M table_mb]
+
+Game i is always played from seed + i, so the statistics do not depend
+on the number of threads (except with a bot looking ahead, whose table
+keeps what it searched in earlier games of its thread; the -M MB are
+split into one table per thread). Games are dealt out in batches: every thread
+starts with an equal share, and a thread that runs out steals half of
+what is left from another one.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "engine.h"
+#include "bot.h"
+#include "bot_weights.h"
+#include "timing.h"
+
+#define SIM_MAX_THREADS 256
+#define SIM_HISTOGRAM 4096 // rows cleared per game are counted up to here
+
+typedef enum {
+    POLICY_GREEDY = 0, // lowest landing spot
+    POLICY_RANDOM, // any spot the shape fits at the top
+    POLICY_BOT, // the computer player from bot.c
+} policy_t;
+
+typedef struct {
+    unsigned int games;
+    unsigned int threads;
+    unsigned int batch;
+    policy_t policy;
+    unsigned int input_us; // time between two player inputs
+    unsigned int tick_us; // armtimer period at the start of a game
+    unsigned int speed_rows; // rows cleared before the armtimer period changes
+    unsigned int speed_tick_us; // armtimer period after that
+    unsigned int gravity_ticks; // armtimer interrupts per gravity step
+    unsigned int clear_us; // pause for the line clear animation
+    unsigned int max_pieces; // games still going after this many pieces are stopped
+    piece_mode_t mode;
+    unsigned int seed;
+    unsigned int depth; // shapes the bot looks ahead
+    unsigned int table_mb; // memory for the bot's transposition table
+} sim_config_t;
+
+// The Pi's schedule, from timing.h
+static sim_config_t config = {
+    .games = 10000,
+    .batch = 16,
+    .policy = POLICY_GREEDY,
+    .input_us = BOT_INPUT_MS * 1000,
+    .tick_us = ARM_TIMER_START_US,
+    .speed_rows = SPEED_ROWS,
+    .speed_tick_us = ARM_TIMER_SPEED_US,
+    .gravity_ticks = ARM_TIMER_START_COUNTER + 1,
+    .clear_us = (CLEAR_BLANK_MS + CLEAR_SCROLL_MS) * 1000,
+    .max_pieces = 5000,
+    .mode = PIECES_RANDOM,
+    .seed = 1,
+    .depth = 1,
+    .table_mb = 64,
+};
+
+typedef struct {
+    unsigned long long games;
+    unsigned long long pieces;
+    unsigned long long inputs; // player inputs
+    unsigned long long steps; // player inputs and gravity steps
+    unsigned long long rows;
+    double squares; // sum of squared rows per game
+    double sim_seconds; // simulated playing time
+    unsigned long long capped; // games stopped at max_pieces
+    unsigned long long steals;
+    unsigned int histogram[SIM_HISTOGRAM + 1]; // last bucket counts everything above
+} sim_stats_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    unsigned int next, end; // games this worker has yet to play
+    sim_stats_t stats;
+    pthread_t thread;
+    unsigned int id;
+    tt_t table; // for this thread's bots, as a table's age cannot be shared
+} worker_t;
+
+static worker_t workers[SIM_MAX_THREADS];
+
+static const bot_weights_t BOT_WEIGHTS = BOT_TUNED_WEIGHTS; // what the Pi plays with
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ------ PLAYER ----*/
+
+typedef struct {
+    rng_t rng;
+    bot_t bot;
+    int orientation; // where the shape in play should go
+    int x;
+} player_t;
+
+/* Picks the spot the shape in play should be dropped at. */
+static void player_aim(player_t *player, const engine_t *engine) {
+    const board_t *board = &engine->board;
+    int best = -1, choices = 0;
+
+    player->orientation = engine->curr.shape.orientation;
+    player->x = engine->curr.x;
+
+    for (int o = 0; o < NUM_ORIENTATIONS; o++) {
+        shape_t shape = { engine->curr.shape.type, o };
+        const shape_info_t *info = shape_info(shape);
+
+        for (int x = -info->left; x + info->right < NUM_COLS; x++) {
+            if (!board_fits(board, x, 0, info)) continue;
+
+            int score;
+            if (config.policy == POLICY_RANDOM) {
+                score = 0;
+            } else { // deepest top, then deepest bottom
+                int y = board_drop_row(board, x, 0, info);
+                score = (y + info->top) * 4 + (y + info->bottom);
+            }
+
+            // Ties are broken at random, keeping each of them with equal chance
+            if (score > best) {
+                best = score;
+                choices = 0;
+            }
+            if (score == best && rng_below(&player->rng, ++choices) == 0) {
+                player->orientation = o;
+                player->x = x;
+            }
+        }
+    }
+}
+
+/* Returns the next input that brings the shape in play to its spot. */
+static input_t player_input(player_t *player, const engine_t *engine) {
+    if (config.policy == POLICY_BOT) return bot_next_input(&player->bot, engine);
+    if (engine->curr.shape.orientation != player->orientation) return INPUT_ROTATE;
+    if (engine->curr.x < player->x) return INPUT_RIGHT;
+    if (engine->curr.x > player->x) return INPUT_LEFT;
+    return INPUT_DOWN;
+}
+
+/* ------ GAMES ----*/
+
+static void play_game(unsigned int index, sim_stats_t *stats, tt_t *table) {
+    engine_t engine;
+    player_t player;
+    event_t events[ENGINE_MAX_EVENTS];
+
+    unsigned int seed = config.seed + index;
+    engine_init(&engine, config.mode);
+    engine_new_game(&engine, seed);
+    rng_seed(&player.rng, seed ^ 0x9E3779B9);
+    bot_init(&player.bot, &BOT_WEIGHTS);
+    bot_lookahead(&player.bot, config.depth, config.depth > 1 ? table : 0);
+    player_aim(&player, &engine);
+
+    unsigned long long tick_us = config.tick_us;
+    unsigned long long clock = 0;
+    unsigned long long next_gravity = tick_us * config.gravity_ticks;
+    unsigned long long next_input = config.input_us;
+    unsigned int pieces = 0, inputs = 0, steps = 0;
+
+    while (!engine.over && pieces < config.max_pieces) {
+        input_t input;
+        if (next_input < next_gravity) {
+            clock = next_input;
+            next_input += config.input_us;
+            input = player_input(&player, &engine);
+            inputs++;
+        } else {
+            clock = next_gravity;
+            next_gravity += tick_us * config.gravity_ticks;
+            input = INPUT_GRAVITY;
+        }
+
+        int count = engine_step(&engine, input, events);
+        steps++;
+        if (count == 0) { // blocked, so drop it where it is
+            player.orientation = engine.curr.shape.orientation;
+            player.x = engine.curr.x;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].type == EVENT_CLEARED) {
+                // The animation stops the armtimer for a while
+                next_gravity += config.clear_us;
+                next_input += config.clear_us;
+
+                unsigned int rows = engine.rowscleared;
+                if (rows >= config.speed_rows && rows - events[i].count < config.speed_rows) {
+                    tick_us = config.speed_tick_us;
+                }
+            } else if (events[i].type == EVENT_SPAWNED) {
+                pieces++;
+                player_aim(&player, &engine);
+            }
+        }
+    }
+
+    unsigned int rows = engine.rowscleared;
+    stats->games++;
+    stats->pieces += pieces;
+    stats->inputs += inputs;
+    stats->steps += steps;
+    stats->rows += rows;
+    stats->squares += (double)rows * rows;
+    stats->sim_seconds += clock * 1e-6;
+    stats->capped += !engine.over;
+    stats->histogram[rows < SIM_HISTOGRAM ? rows : SIM_HISTOGRAM]++;
+}
+
+/* ------ WORK STEALING ----*/
+
+/* Takes the next batch of games from the worker's own share, or steals
+   half of another worker's share when its own is used up. Returns 0
+   once every share is empty. */
+static int take_batch(worker_t *self, unsigned int *first, unsigned int *last) {
+    for (;;) {
+        pthread_mutex_lock(&self->lock);
+        if (self->next < self->end) {
+            *first = self->next;
+            *last = self->next + config.batch < self->end ? self->next + config.batch : self->end;
+            self->next = *last;
+            pthread_mutex_unlock(&self->lock);
+            return 1;
+        }
+        pthread_mutex_unlock(&self->lock);
+
+        unsigned int from = 0, to = 0;
+        for (unsigned int i = 1; i < config.threads && from == to; i++) {
+            worker_t *victim = &workers[(self->id + i) % config.threads];
+            pthread_mutex_lock(&victim->lock);
+            unsigned int left = victim->end - victim->next;
+            if (left > 0) {
+                // Leave the victim the half it is about to play
+                to = victim->end;
+                from = left > config.batch ? victim->end - left / 2 : victim->next;
+                victim->end = from;
+            }
+            pthread_mutex_unlock(&victim->lock);
+        }
+
+        if (from == to) {
+            return 0;
+        }
+
+        pthread_mutex_lock(&self->lock);
+        self->next = from;
+        self->end = to;
+        self->stats.steals++;
+        pthread_mutex_unlock(&self->lock);
+    }
+}
+
+static void *worker_main(void *arg) {
+    worker_t *self = arg;
+    unsigned int first, last;
+
+    while (take_batch(self, &first, &last)) {
+        for (unsigned int game = first; game < last; game++) {
+            play_game(game, &self->stats, &self->table);
+        }
+    }
+    return NULL;
+}
+
+/* ------ REPORT ----*/
+
+/* Returns the smallest score at least 'fraction' of the games stayed at or below. */
+static unsigned int percentile(const sim_stats_t *stats, double fraction) {
+    unsigned long long seen = 0;
+    for (unsigned int rows = 0; rows <= SIM_HISTOGRAM; rows++) {
+        seen += stats->histogram[rows];
+        if (seen >= fraction * stats->games) return rows;
+    }
+    return SIM_HISTOGRAM;
+}
+
+static void report(const sim_stats_t *total, double seconds) {
+    double games = total->games;
+    double mean = total->rows / games;
+    double stddev = sqrt(total->squares / games - mean * mean);
+
+    printf("schedule     %u ms ticks, gravity every %u ticks, %u ms ticks from %u rows, %u ms per input\n",
+           config.tick_us / 1000, config.gravity_ticks, config.speed_tick_us / 1000,
+           config.speed_rows, config.input_us / 1000);
+    printf("played       %.0f games on %u threads in %.2f s, %llu steals\n",
+           games, config.threads, seconds, total->steals);
+    printf("speed        %12.0f games/sec %12.0f pieces/sec %12.0f steps/sec\n",
+           games / seconds, total->pieces / seconds,
+           total->steps / seconds);
+    printf("per game     %.1f pieces, %.1f inputs, %.1f s of play, %llu stopped at %u pieces\n",
+           total->pieces / games, total->inputs / games, total->sim_seconds / games,
+           total->capped, config.max_pieces);
+    printf("rows         mean %.2f  stddev %.2f  p10 %u  p25 %u  p50 %u  p75 %u  p90 %u  p99 %u\n",
+           mean, stddev, percentile(total, 0.10), percentile(total, 0.25), percentile(total, 0.50),
+           percentile(total, 0.75), percentile(total, 0.90), percentile(total, 0.99));
+
+    // Buckets double in width so long games fit on a screen
+    for (unsigned int low = 0, high = 0; low <= SIM_HISTOGRAM; low = high + 1, high = high ? 2*high + 1 : 1) {
+        unsigned long long count = 0;
+        for (unsigned int rows = low; rows <= high && rows <= SIM_HISTOGRAM; rows++) {
+            count += total->histogram[rows];
+        }
+        if (count == 0) continue;
+
+        int bar = (int)(50.0 * count / games + 0.5);
+        printf("  %5u-%-5u %8llu %5.1f%% %.*s\n", low, high, count, 100.0 * count / games,
+               bar, "##################################################");
+    }
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-g games] [-t threads] [-b batch] [-p greedy|random|bot] [-i input_ms]\n"
+                    "          [-s speed_rows] [-f fast_ms] [-S slow_ms] [-n max_pieces] [-m bag] [-x seed]\n"
+                    "          [-d depth] [-M table_mb]\n", name);
+    exit(2);
+}
+
+int main(int argc, char *argv[]) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    config.threads = cores > 0 ? cores : 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0' || i + 1 == argc) usage(argv[0]);
+        const char *value = argv[++i];
+        unsigned int number = strtoul(value, NULL, 0);
+
+        switch (argv[i - 1][1]) {
+        case 'g': config.games = number; break;
+        case 't': config.threads = number; break;
+        case 'b': config.batch = number; break;
+        case 'p':
+            config.policy = strcmp(value, "random") == 0 ? POLICY_RANDOM :
+                            strcmp(value, "bot") == 0 ? POLICY_BOT : POLICY_GREEDY;
+            break;
+        case 'i': config.input_us = number * 1000; break;
+        case 's': config.speed_rows = number; break;
+        case 'f': config.tick_us = number * 1000; break;
+        case 'S': config.speed_tick_us = number * 1000; break;
+        case 'n': config.max_pieces = number; break;
+        case 'm': config.mode = strcmp(value, "bag") == 0 ? PIECES_BAG : PIECES_RANDOM; break;
+        case 'x': config.seed = number; break;
+        case 'd': config.depth = number; break;
+        case 'M': config.table_mb = number; break;
+        default: usage(argv[0]);
+        }
+    }
+
+    if (config.threads < 1) config.threads = 1;
+    if (config.threads > SIM_MAX_THREADS) config.threads = SIM_MAX_THREADS;
+    if (config.batch < 1) config.batch = 1;
+    if (config.input_us < 1) config.input_us = 1;
+
+    // Equal shares to start with
+    for (unsigned int t = 0; t < config.threads; t++) {
+        worker_t *worker = &workers[t];
+        if (config.policy == POLICY_BOT && config.depth > 1) {
+            unsigned long bytes = ((unsigned long)config.table_mb << 20) / config.threads;
+            void *memory = malloc(bytes);
+            if (memory == NULL) {
+                fprintf(stderr, "sim: cannot allocate a %u MB table\n", config.table_mb);
+                return 1;
+            }
+            tt_init(&worker->table, memory, bytes);
+        }
+        pthread_mutex_init(&worker->lock, NULL);
+        worker->id = t;
+        worker->next = (unsigned long long)config.games * t / config.threads;
+        worker->end = (unsigned long long)config.games * (t + 1) / config.threads;
+    }
+
+    double begin = now();
+    for (unsigned int t = 0; t < config.threads; t++) {
+        pthread_create(&workers[t].thread, NULL, worker_main, &workers[t]);
+    }
+
+    static sim_stats_t total;
+    tt_t table = {0}; // the counters of all the threads' tables
+    for (unsigned int t = 0; t < config.threads; t++) {
+        const sim_stats_t *stats = &workers[t].stats;
+        pthread_join(workers[t].thread, NULL);
+
+        table.buckets += workers[t].table.buckets;
+        table.hits += workers[t].table.hits;
+        table.misses += workers[t].table.misses;
+        table.stores += workers[t].table.stores;
+        table.replaced += workers[t].table.replaced;
+
+        total.games += stats->games;
+        total.pieces += stats->pieces;
+        total.inputs += stats->inputs;
+        total.steps += stats->steps;
+        total.rows += stats->rows;
+        total.squares += stats->squares;
+        total.sim_seconds += stats->sim_seconds;
+        total.capped += stats->capped;
+        total.steals += stats->steals;
+        for (unsigned int rows = 0; rows <= SIM_HISTOGRAM; rows++) {
+            total.histogram[rows] += stats->histogram[rows];
+        }
+    }
+    double seconds = now() - begin;
+
+    if (total.games == 0) {
+        printf("no games played\n");
+        return 0;
+    }
+    report(&total, seconds);
+    if (table.buckets) {
+        printf("table        %.1f%% hits, %llu stores, %llu replaced\n",
+               100.0 * table.hits / (table.hits + table.misses), table.stores, table.replaced);
+    }
+    return 0;
+}
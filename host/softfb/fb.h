@@ -0,0 +1,16 @@
+#ifndef FB_H
+#define FB_H
+
+/* The part of the CS107E fb module the renderer uses, for the host. */
+
+typedef enum { FB_SINGLEBUFFER = 0, FB_DOUBLEBUFFER = 1 } fb_mode_t;
+
+void fb_init(unsigned int width, unsigned int height, unsigned int depth_in_bytes, fb_mode_t mode);
+unsigned int fb_get_width(void);
+unsigned int fb_get_height(void);
+unsigned int fb_get_depth(void);
+unsigned int fb_get_pitch(void);
+void *fb_get_draw_buffer(void);
+void fb_swap_buffer(void);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef GL_H
+#define GL_H
+
+/* The part of the CS107E gl module the renderer uses, for the host.
+
+Draws into the software framebuffer in softfb.c. Colors are 32-bit
+ARGB like on the Pi.
+*/
+
+typedef unsigned int color_t;
+
+#define GL_BLACK    0xFF000000
+#define GL_WHITE    0xFFFFFFFF
+#define GL_RED      0xFFFF0000
+#define GL_GREEN    0xFF00FF00
+#define GL_BLUE     0xFF0000FF
+#define GL_CYAN     0xFF00FFFF
+#define GL_MAGENTA  0xFFFF00FF
+#define GL_YELLOW   0xFFFFFF00
+#define GL_AMBER    0xFFFFBF00
+#define GL_ORANGE   0xFFFF3F00
+#define GL_PURPLE   0xFF7F00FF
+
+typedef enum { GL_SINGLEBUFFER = 0, GL_DOUBLEBUFFER = 1 } gl_mode_t;
+
+void gl_init(unsigned int width, unsigned int height, gl_mode_t mode);
+unsigned int gl_get_width(void);
+unsigned int gl_get_height(void);
+void gl_swap_buffer(void);
+void gl_clear(color_t c);
+void gl_draw_pixel(int x, int y, color_t c);
+color_t gl_read_pixel(int x, int y);
+void gl_draw_rect(int x, int y, int w, int h, color_t c);
+
+#endif
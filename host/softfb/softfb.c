@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include "softfb.h"
+#include "fb.h"
+
+softfb_stats_t softfb_stats;
+
+static struct {
+    unsigned int width, height;
+    int doublebuffer;
+    color_t *buffers[2];
+    int draw; // index of the buffer drawn into
+} fb;
+
+void fb_init(unsigned int width, unsigned int height, unsigned int depth_in_bytes, fb_mode_t mode) {
+    if (fb.buffers[1] != fb.buffers[0]) free(fb.buffers[1]); // one buffer when single buffered
+    free(fb.buffers[0]);
+
+    // Only 32-bit color, like gl
+    fb.width = width;
+    fb.height = height;
+    fb.doublebuffer = (mode == FB_DOUBLEBUFFER);
+    fb.buffers[0] = calloc((size_t)width * height, sizeof(color_t));
+    fb.buffers[1] = fb.doublebuffer ? calloc((size_t)width * height, sizeof(color_t)) : fb.buffers[0];
+    fb.draw = fb.doublebuffer;
+    (void)depth_in_bytes;
+}
+
+unsigned int fb_get_width(void) {
+    return fb.width;
+}
+
+unsigned int fb_get_height(void) {
+    return fb.height;
+}
+
+unsigned int fb_get_depth(void) {
+    return sizeof(color_t);
+}
+
+unsigned int fb_get_pitch(void) {
+    return fb.width * sizeof(color_t);
+}
+
+void *fb_get_draw_buffer(void) {
+    return fb.buffers[fb.draw];
+}
+
+void *softfb_display_buffer(void) {
+    return fb.buffers[fb.doublebuffer ? !fb.draw : 0];
+}
+
+void fb_swap_buffer(void) {
+    if (fb.doublebuffer) fb.draw = !fb.draw;
+    softfb_stats.swaps++;
+}
+
+void gl_init(unsigned int width, unsigned int height, gl_mode_t mode) {
+    fb_init(width, height, sizeof(color_t), (fb_mode_t)mode);
+}
+
+unsigned int gl_get_width(void) {
+    return fb.width;
+}
+
+unsigned int gl_get_height(void) {
+    return fb.height;
+}
+
+void gl_swap_buffer(void) {
+    fb_swap_buffer();
+}
+
+void gl_clear(color_t c) {
+    gl_draw_rect(0, 0, fb.width, fb.height, c);
+}
+
+void gl_draw_pixel(int x, int y, color_t c) {
+    gl_draw_rect(x, y, 1, 1, c);
+}
+
+color_t gl_read_pixel(int x, int y) {
+    if (x < 0 || y < 0 || x >= fb.width || y >= fb.height) return 0;
+    return fb.buffers[fb.draw][y*fb.width + x];
+}
+
+void gl_draw_rect(int x, int y, int w, int h, color_t c) {
+    // Clipped to the screen, like gl does
+    int right = x + w > (int)fb.width ? (int)fb.width : x + w;
+    int bottom = y + h > (int)fb.height ? (int)fb.height : y + h;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+
+    color_t *buffer = fb.buffers[fb.draw];
+    for (int row = y; row < bottom; row++) {
+        for (int col = x; col < right; col++) {
+            buffer[row*fb.width + col] = c;
+        }
+    }
+    if (right > x && bottom > y) softfb_stats.pixels += (unsigned long long)(right - x) * (bottom - y);
+}
@@ -0,0 +1,26 @@
+#ifndef SOFTFB_H
+#define SOFTFB_H
+
+#include "gl.h"
+
+/* A framebuffer in memory behind the gl and fb functions, so the
+renderer can run and be measured on the host.
+
+It counts the swaps and the pixels written through gl, which is what
+drawing costs on the Pi.
+*/
+
+typedef struct {
+    unsigned long long swaps;
+    unsigned long long pixels;
+} softfb_stats_t;
+
+extern softfb_stats_t softfb_stats;
+
+/* 'softfb_display_buffer'
+
+Returns the buffer on screen, the one that is not drawn into.
+*/
+void *softfb_display_buffer(void);
+
+#endif
@@ -0,0 +1,484 @@
+/* Genetic tuner for the bot's weights.
+
+Evolves a population of weight vectors by letting each of them play the
+same seeded games on the headless engine, across a pool of threads.
+Every shape is planned once where it comes into play and dropped where
+the plan says; a vector is worth the rows it clears per game. The games
+change every generation, so a vector only stays on top by playing well
+on games it has not seen.
+
+Those games are luckier in some generations than in others, so the top
+vector of a generation is played again on a fixed set of validation
+games, seeded apart from the ones the population plays. It only becomes
+the best vector of the run if it clears more rows there than the best so
+far, which is scored on the same games when a run starts or resumes.
+
+Each generation keeps its best vectors as they are and fills the rest
+of the population with children of two parents picked by tournament:
+every weight comes from either parent or their average, and is then
+nudged at random. All the randomness comes from one seeded generator,
+so a run can be repeated exactly.
+
+    ./tune [-p population] [-g games] [-v validation_games] [-n max_pieces]
+           [-G generations] [-t threads] [-e elite] [-m bag] [-x seed]
+           [-c checkpoint] [-r] [-o header]
+
+After every generation the whole state of the run goes to the
+checkpoint file (tune.ckpt), and -r picks a run up from it after a stop.
+The best vector so far is written to the header (bot_weights.h) as
+BOT_TUNED_WEIGHTS, which the Pi build compiles in; run the tuner from
+the top directory, or point -o there.
+*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "engine.h"
+#include "bot.h"
+
+#define TUNE_MAX_POPULATION 256
+#define TUNE_MAX_THREADS 256
+#define TUNE_BATCH 4 // games a thread takes from the pool at a time
+#define TUNE_WEIGHTS 4
+#define TUNE_TOURNAMENT 3
+#define TUNE_CHECKPOINT_VERSION 2
+#define TUNE_VALIDATION_SEED 0x80000000u // added to the run's seed, far from the seeds generations play
+
+typedef struct {
+    unsigned int population;
+    unsigned int games; // per vector and generation
+    unsigned int validation; // games the best vectors are compared on
+    unsigned int max_pieces; // games still going after this many pieces are stopped
+    unsigned int generations; // stop after this many, 0 to go on until stopped
+    unsigned int threads;
+    unsigned int elite; // best vectors kept as they are
+    piece_mode_t mode;
+    unsigned int seed;
+    const char *checkpoint;
+    const char *header;
+} tune_config_t;
+
+static tune_config_t config = {
+    .population = 24,
+    .games = 32,
+    .validation = 128,
+    .max_pieces = 2000,
+    .generations = 0,
+    .elite = 2,
+    .mode = PIECES_RANDOM,
+    .seed = 1,
+    .checkpoint = "tune.ckpt",
+    .header = "bot_weights.h",
+};
+
+typedef struct {
+    int w[TUNE_WEIGHTS]; // height, lines, holes, bumpiness, as in bot_weights_t
+    double fitness; // rows cleared per game in the last generation it played, or the validation games for the best
+} vector_t;
+
+// The whole state of a run, as saved in the checkpoint
+static struct {
+    unsigned int generation; // next one to play
+    rng_t rng;
+    vector_t population[TUNE_MAX_POPULATION];
+    vector_t best; // best vector of any generation so far
+    unsigned int best_generation;
+} run;
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ------ GAMES ----*/
+
+/* Plays one game with the weights and returns the rows cleared. */
+static unsigned int play_game(const vector_t *vector, unsigned int seed, unsigned int *pieces) {
+    const bot_weights_t weights = { vector->w[0], vector->w[1], vector->w[2], vector->w[3] };
+    engine_t engine;
+    bot_t bot;
+    event_t events[ENGINE_MAX_EVENTS];
+    input_t path[REACH_MAX_PATH];
+
+    engine_init(&engine, config.mode);
+    engine_new_game(&engine, seed);
+    bot_init(&bot, &weights);
+
+    while (!engine.over && engine.spawned < config.max_pieces) {
+        unsigned int spawned = engine.spawned;
+        bot_plan(&bot, &engine);
+
+        // Follow the plan, then let gravity land the shape
+        int len = reach_path(&bot.reach[0], bot.target, path);
+        for (int i = 0; i < len; i++) {
+            engine_step(&engine, path[i], events);
+        }
+        while (!engine.over && engine.spawned == spawned) {
+            engine_step(&engine, INPUT_GRAVITY, events);
+        }
+    }
+
+    *pieces = engine.spawned;
+    return engine.rowscleared;
+}
+
+/* ------ THREAD POOL ----*/
+
+// A set of games to play: game g of vector v is item v * games + g, with seed 'seed' + g
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t start; // a set is ready
+    pthread_cond_t done; // its last item is finished
+    unsigned int generation; // bumped to start one
+    const vector_t *vectors;
+    unsigned int games;
+    unsigned int seed;
+    unsigned int next; // first item nobody has taken
+    unsigned int items;
+    unsigned int finished;
+    int quit;
+} pool;
+
+static unsigned int rows[TUNE_MAX_POPULATION * 1024]; // per item
+static unsigned long long pieces_played;
+
+static void *worker_main(void *arg) {
+    unsigned int seen = 0;
+    (void)arg;
+
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.generation == seen && !pool.quit) {
+            pthread_cond_wait(&pool.start, &pool.lock);
+        }
+        if (pool.quit) break;
+
+        // Take games in small batches until the set has none left
+        while (pool.next < pool.items) {
+            unsigned int first = pool.next;
+            unsigned int last = first + TUNE_BATCH < pool.items ? first + TUNE_BATCH : pool.items;
+            pool.next = last;
+            pthread_mutex_unlock(&pool.lock);
+
+            unsigned long long pieces = 0;
+            for (unsigned int item = first; item < last; item++) {
+                unsigned int v = item / pool.games, g = item % pool.games, count;
+                rows[item] = play_game(&pool.vectors[v], pool.seed + g, &count);
+                pieces += count;
+            }
+
+            pthread_mutex_lock(&pool.lock);
+            pieces_played += pieces;
+            pool.finished += last - first;
+            if (pool.finished == pool.items) pthread_cond_signal(&pool.done);
+        }
+        seen = pool.generation;
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+/* Plays 'games' games from seed 'seed' on with each of 'count' vectors
+   on the pool, leaving the rows of each in 'rows', and waits for them. */
+static void play_games(const vector_t *vectors, unsigned int count, unsigned int games, unsigned int seed) {
+    pthread_mutex_lock(&pool.lock);
+    pool.vectors = vectors;
+    pool.games = games;
+    pool.seed = seed;
+    pool.next = 0;
+    pool.finished = 0;
+    pool.items = count * games;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.start);
+    while (pool.finished < pool.items) {
+        pthread_cond_wait(&pool.done, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/* Plays every game of the generation and scores the population on them. */
+static void play_generation(void) {
+    play_games(run.population, config.population, config.games, config.seed + run.generation * config.games);
+
+    for (unsigned int v = 0; v < config.population; v++) {
+        unsigned long long total = 0;
+        for (unsigned int g = 0; g < config.games; g++) {
+            total += rows[v * config.games + g];
+        }
+        run.population[v].fitness = (double)total / config.games;
+    }
+}
+
+/* Returns the rows per game the vector clears on the validation games,
+   which are the same in every generation. */
+static double validate(const vector_t *vector) {
+    unsigned long long total = 0;
+
+    play_games(vector, 1, config.validation, config.seed + TUNE_VALIDATION_SEED);
+    for (unsigned int g = 0; g < config.validation; g++) {
+        total += rows[g];
+    }
+    return (double)total / config.validation;
+}
+
+/* ------ EVOLUTION ----*/
+
+static int by_fitness(const void *a, const void *b) {
+    double fa = ((const vector_t *)a)->fitness, fb = ((const vector_t *)b)->fitness;
+    return fa < fb ? 1 : fa > fb ? -1 : 0;
+}
+
+/* Returns the best of a few vectors picked at random from the sorted population. */
+static const vector_t *tournament(void) {
+    unsigned int pick = rng_below(&run.rng, config.population);
+    for (int i = 1; i < TUNE_TOURNAMENT; i++) {
+        unsigned int other = rng_below(&run.rng, config.population);
+        if (other < pick) pick = other;
+    }
+    return &run.population[pick];
+}
+
+/* Nudges a weight by up to a fifth of its size, and at least by 2. */
+static int mutate(int weight) {
+    int reach = abs(weight) / 5 > 2 ? abs(weight) / 5 : 2;
+    return weight + (int)rng_below(&run.rng, 2 * reach + 1) - reach;
+}
+
+/* Replaces everything but the elite of the sorted population with children. */
+static void breed(void) {
+    static vector_t children[TUNE_MAX_POPULATION];
+
+    for (unsigned int c = config.elite; c < config.population; c++) {
+        const vector_t *a = tournament(), *b = tournament();
+        for (int i = 0; i < TUNE_WEIGHTS; i++) {
+            switch (rng_below(&run.rng, 3)) {
+            case 0: children[c].w[i] = a->w[i]; break;
+            case 1: children[c].w[i] = b->w[i]; break;
+            default: children[c].w[i] = (a->w[i] + b->w[i]) / 2; break;
+            }
+            if (rng_below(&run.rng, 3) == 0) children[c].w[i] = mutate(children[c].w[i]);
+        }
+        children[c].fitness = 0;
+    }
+    for (unsigned int c = config.elite; c < config.population; c++) {
+        run.population[c] = children[c];
+    }
+}
+
+/* Starts a new run from the default weights and mutated copies of them. */
+static void seed_population(void) {
+    const bot_weights_t defaults = BOT_DEFAULT_WEIGHTS;
+    const int start[TUNE_WEIGHTS] = { defaults.height, defaults.lines, defaults.holes, defaults.bumpiness };
+
+    rng_seed(&run.rng, config.seed);
+    run.generation = 0;
+    run.best_generation = 0;
+    run.best.fitness = -1;
+    for (unsigned int v = 0; v < config.population; v++) {
+        for (int i = 0; i < TUNE_WEIGHTS; i++) {
+            run.population[v].w[i] = v == 0 ? start[i] : mutate(mutate(start[i]));
+        }
+        run.population[v].fitness = 0;
+    }
+}
+
+/* ------ FILES ----*/
+
+/* Writes the state of the run to a new file and moves it over the
+   checkpoint, so a stop while writing leaves the old one intact. */
+static int save_checkpoint(void) {
+    char temp[1024];
+    snprintf(temp, sizeof(temp), "%s.tmp", config.checkpoint);
+    FILE *file = fopen(temp, "w");
+    if (!file) return 0;
+
+    fprintf(file, "tune %d\n", TUNE_CHECKPOINT_VERSION);
+    fprintf(file, "config %u %u %u %u %d %u %u\n", config.population, config.games, config.max_pieces,
+            config.elite, config.mode, config.seed, config.validation);
+    fprintf(file, "generation %u\n", run.generation);
+    fprintf(file, "rng %u %u %u %u\n", run.rng.s[0], run.rng.s[1], run.rng.s[2], run.rng.s[3]);
+    fprintf(file, "best %u %d %d %d %d %.17g\n", run.best_generation,
+            run.best.w[0], run.best.w[1], run.best.w[2], run.best.w[3], run.best.fitness);
+    for (unsigned int v = 0; v < config.population; v++) {
+        const vector_t *p = &run.population[v];
+        fprintf(file, "vector %d %d %d %d %.17g\n", p->w[0], p->w[1], p->w[2], p->w[3], p->fitness);
+    }
+
+    int ok = fclose(file) == 0;
+    return ok && rename(temp, config.checkpoint) == 0;
+}
+
+/* Reads the run back from the checkpoint, its settings included. */
+static int load_checkpoint(void) {
+    FILE *file = fopen(config.checkpoint, "r");
+    int version, mode, ok;
+    if (!file) return 0;
+
+    ok = fscanf(file, " tune %d", &version) == 1 && version == TUNE_CHECKPOINT_VERSION &&
+         fscanf(file, " config %u %u %u %u %d %u %u", &config.population, &config.games, &config.max_pieces,
+                &config.elite, &mode, &config.seed, &config.validation) == 7 &&
+         config.population <= TUNE_MAX_POPULATION &&
+         fscanf(file, " generation %u", &run.generation) == 1 &&
+         fscanf(file, " rng %u %u %u %u", &run.rng.s[0], &run.rng.s[1], &run.rng.s[2], &run.rng.s[3]) == 4 &&
+         fscanf(file, " best %u %d %d %d %d %lg", &run.best_generation, &run.best.w[0], &run.best.w[1],
+                &run.best.w[2], &run.best.w[3], &run.best.fitness) == 6;
+    for (unsigned int v = 0; ok && v < config.population; v++) {
+        vector_t *p = &run.population[v];
+        ok = fscanf(file, " vector %d %d %d %d %lg", &p->w[0], &p->w[1], &p->w[2], &p->w[3], &p->fitness) == 5;
+    }
+    config.mode = mode == PIECES_BAG ? PIECES_BAG : PIECES_RANDOM;
+
+    fclose(file);
+    return ok;
+}
+
+/* Writes the best vector as a header for the Pi build. */
+static int write_header(void) {
+    FILE *file = fopen(config.header, "w");
+    if (!file) return 0;
+
+    fprintf(file, "#ifndef BOT_WEIGHTS_H\n#define BOT_WEIGHTS_H\n\n");
+    fprintf(file, "/* Weights the bot plays with on the Pi, written by host/tune.\n\n");
+    fprintf(file, "The best of generation %u of a run from seed %u, which cleared %.1f rows\n",
+            run.best_generation, config.seed, run.best.fitness);
+    fprintf(file, "per game over the run's %u validation games of at most %u pieces.\n*/\n\n", config.validation,
+            config.max_pieces);
+    fprintf(file, "#define BOT_TUNED_WEIGHTS { %d, %d, %d, %d } // height, lines, holes, bumpiness\n\n",
+            run.best.w[0], run.best.w[1], run.best.w[2], run.best.w[3]);
+    fprintf(file, "#endif\n");
+    return fclose(file) == 0;
+}
+
+/* ------ DRIVER ----*/
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-p population] [-g games] [-v validation_games] [-n max_pieces] [-G generations]\n"
+                    "          [-t threads] [-e elite] [-m bag] [-x seed] [-c checkpoint] [-r] [-o header]\n", name);
+    exit(2);
+}
+
+int main(int argc, char *argv[]) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    int resume = 0;
+    config.threads = cores > 0 ? cores : 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0') usage(argv[0]);
+        if (argv[i][1] == 'r') {
+            resume = 1;
+            continue;
+        }
+        if (i + 1 == argc) usage(argv[0]);
+        const char *value = argv[++i];
+        unsigned int number = strtoul(value, NULL, 0);
+
+        switch (argv[i - 1][1]) {
+        case 'p': config.population = number; break;
+        case 'g': config.games = number; break;
+        case 'v': config.validation = number; break;
+        case 'n': config.max_pieces = number; break;
+        case 'G': config.generations = number; break;
+        case 't': config.threads = number; break;
+        case 'e': config.elite = number; break;
+        case 'm': config.mode = strcmp(value, "bag") == 0 ? PIECES_BAG : PIECES_RANDOM; break;
+        case 'x': config.seed = number; break;
+        case 'c': config.checkpoint = value; break;
+        case 'o': config.header = value; break;
+        default: usage(argv[0]);
+        }
+    }
+
+    if (resume) {
+        if (!load_checkpoint()) {
+            fprintf(stderr, "tune: cannot resume from %s\n", config.checkpoint);
+            return 1;
+        }
+        printf("resuming     %s at generation %u\n", config.checkpoint, run.generation);
+    }
+
+    if (config.threads < 1) config.threads = 1;
+    if (config.threads > TUNE_MAX_THREADS) config.threads = TUNE_MAX_THREADS;
+    if (config.population < 2) config.population = 2;
+    if (config.population > TUNE_MAX_POPULATION) config.population = TUNE_MAX_POPULATION;
+    if (config.games < 1) config.games = 1;
+    if (config.games > sizeof(rows) / sizeof(rows[0]) / config.population) {
+        config.games = sizeof(rows) / sizeof(rows[0]) / config.population;
+    }
+    if (config.validation < 1) config.validation = 1;
+    if (config.validation > sizeof(rows) / sizeof(rows[0])) config.validation = sizeof(rows) / sizeof(rows[0]);
+    if (config.elite >= config.population) config.elite = config.population - 1;
+    if (!resume) seed_population();
+
+    printf("tuning       %u vectors, %u games of up to %u pieces each, %u kept, %u to validate, seed %u, %u threads\n",
+           config.population, config.games, config.max_pieces, config.elite, config.validation, config.seed,
+           config.threads);
+
+    pthread_t threads[TUNE_MAX_THREADS];
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.start, NULL);
+    pthread_cond_init(&pool.done, NULL);
+    for (unsigned int t = 0; t < config.threads; t++) {
+        pthread_create(&threads[t], NULL, worker_main, NULL);
+    }
+
+    // The best so far is only ever compared on the validation games
+    if (run.best.fitness >= 0) {
+        run.best.fitness = validate(&run.best);
+        printf("best         { %d, %d, %d, %d } validates at %.1f\n", run.best.w[0], run.best.w[1], run.best.w[2],
+               run.best.w[3], run.best.fitness);
+    }
+
+    for (unsigned int played = 0; config.generations == 0 || played < config.generations; played++) {
+        double start = now();
+        pieces_played = 0;
+        play_generation();
+        double seconds = now() - start;
+
+        qsort(run.population, config.population, sizeof(vector_t), by_fitness);
+        double mean = 0;
+        for (unsigned int v = 0; v < config.population; v++) {
+            mean += run.population[v].fitness / config.population;
+        }
+
+        const vector_t *top = &run.population[0];
+        double validated = validate(top);
+        int improved = validated > run.best.fitness;
+        if (improved) {
+            run.best = *top;
+            run.best.fitness = validated;
+            run.best_generation = run.generation;
+        }
+        printf("gen %-8u best %7.1f  mean %7.1f  worst %7.1f  %6.0f games/s %9.0f pieces/s %6.1f s  "
+               "{ %d, %d, %d, %d } validates at %.1f%s\n", run.generation, top->fitness, mean,
+               run.population[config.population - 1].fitness, config.population * config.games / seconds,
+               pieces_played / seconds, seconds, top->w[0], top->w[1], top->w[2], top->w[3], validated,
+               improved ? " new best" : "");
+
+        run.generation++;
+        breed();
+        if (!save_checkpoint()) {
+            fprintf(stderr, "tune: cannot write %s\n", config.checkpoint);
+            return 1;
+        }
+        if (improved && !write_header()) {
+            fprintf(stderr, "tune: cannot write %s\n", config.header);
+            return 1;
+        }
+        fflush(stdout);
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.quit = 1;
+    pthread_cond_broadcast(&pool.start);
+    pthread_mutex_unlock(&pool.lock);
+    for (unsigned int t = 0; t < config.threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    return 0;
+}
@@ -18,6 +18,14 @@
 #include "printf.h"
 #include "timer.h"
 #include "tetris_audio.h"
+#include "replay.h"
+#include "bot.h"
+#include "beam.h"
+#include "bot_weights.h"
+#include "render.h"
+#include "damage.h"
+#include "span.h"
+#include "timing.h" // the armtimer, gravity and animation schedule
 
 
 struct wav_format {
@@ -39,16 +47,22 @@ struct wav_format {
 /* ------ SENSOR CONTROLS  ----*/
 /* Levers for fine-tuning sensitivy and performance - EDIT THESE */
 #define COOLDOWN_TIME 25
-#define ARM_TIMER_START_COUNTER 10
 
 /* ------ GAMEPLAY CONTROLS  ----*/
 
 #define BLOCK_SIZE 50
 #define PADDING_Y 20
 #define BORDER_THICKNESS 3
-#define NUM_ROWS 20
-#define NUM_COLS 10
 #define SCORE_DIGITS 5
+#define PIECE_MODE PIECES_RANDOM // PIECES_BAG deals all seven shapes before repeating any
+#define BOT_DEPTH 2 // shapes the bot looks ahead, counting the one in play
+#define BOT_TT_BYTES (64*1024) // memory for the positions the bot has searched
+#define BOT_BEAM_WIDTH 16 // positions the beam search keeps per shape, 0 to use the lookahead instead
+#define BOT_BEAM_DEPTH BEAM_MAX_DEPTH // shapes the beam search looks ahead, counting the one in play
+#define BOT_BEAM_US 20000 // time the beam search gets per shape
+#define ATTRACT_TITLE_SECONDS 5 // title shown before the demo game starts
+#define ATTRACT_INPUT_TICKS 1 // armtimer interrupts between two of the demo bot's inputs
+#define ATTRACT_BEAM_US 4000 // planning time per shape in the demo, short so a key is not kept waiting
 
 /* ------ SENSOR VARS  ----*/
 sensor_info_t *sensor; // sensor input
@@ -70,8 +84,6 @@ unsigned int SCREEN_HEIGHT;
 unsigned int PADDING_X;
 
 // For the score
-unsigned int rowscleared;
-unsigned int mostrows;
 char score[SCORE_DIGITS + 1];
 char highscore[SCORE_DIGITS + 1];
 unsigned int SCORE_X; // SCORE_X and SCORE_Y initialized in score_init()
@@ -79,18 +91,48 @@ unsigned int SCORE_Y;
 
 // Definition for keyboard inputs 
 static input_fn_t controls_read;
-
-/*For the placedblocks array, these indicate the location 
-of the currently dropping block. We have an 'x' and a 'y'. */
-
-shape_t currshape; // Shape in play
-shape_t nextshape; // Shape on side
-char **placedblocks; // 2D array of blocks that have been placed
-int startingX; // Starting x position. Middle of the screen minus 1;
-int currX; // Current x position of the block
-int currY; // Current y position of the block (minus one is top left corner of the block-to-be-placed)
-int lastX; // Last x position of the block
-unsigned int realY; // used in read_input
+static input_ready_fn_t controls_ready;
+
+/* The game itself: placed blocks, the shape in play and its position,
+the next shape and the score. Everything below only draws it and feeds
+it inputs. */
+engine_t game;
+
+/* Every input fed to the game is logged and streamed over the UART as
+"@replay" lines of hex, so host/replay can play the game back. */
+replay_writer_t replaylog;
+unsigned int ticks; // armtimer interrupts so far, the time base of the log
+
+/* The playfield as drawn: moves mark the cells they change and each
+step ends with one frame, drawn into the back buffer and swapped in. */
+static render_t playfield;
+
+/* What each buffer has missed of everything else drawn, so a refresh
+only copies those regions over from the buffer on screen. */
+static damage_t screen_damage;
+
+// The blocks of the title and the preview, with their two pixel outline
+static tile_t bound_tiles[NUM_SHAPES];
+
+// Computer player, for when bot_read_next() is the input function
+static bot_t bot;
+static const bot_weights_t BOT_WEIGHTS = BOT_TUNED_WEIGHTS;
+static tt_t bot_tt;
+static tt_entry_t bot_tt_memory[BOT_TT_BYTES / sizeof(tt_entry_t)];
+static beam_t bot_planner;
+static beam_node_t bot_planner_nodes[2 * BOT_BEAM_WIDTH + 1];
+
+/* Attract mode: after the title, the bot plays demo games until a key
+is pressed or the glove is tilted. The armtimer interrupt only marks
+gravity and one bot input every ATTRACT_INPUT_TICKS as due, and the
+main loop plays them between checks for a key, so the interrupt stays
+short and the keyboard's own interrupts are not held off. */
+static volatile bool attract;
+static unsigned int attract_ticks;
+static volatile bool attract_gravity_due;
+static volatile bool attract_input_due;
+static volatile bool attract_tilted;
+static unsigned int attract_best; // high score from before the demo, which must not beat it
 
 
 /* ------ GAMEPLAY/GRAPHICAL/INPUT FUNCTIONS ----*/
@@ -122,14 +164,23 @@ void sensor_dev_init(void) {
 
 /* During swap, we must copy the information from the 
 old draw buf (new display buf) into new draw buf (old
-display buf), so we can "save our progress" as we draw. */
+display buf), so we can "save our progress" as we draw.
+Only the regions drawn since this buffer was last caught
+up are copied. */
 void screen_copy_buffer(char *display, char *draw) {
-    char *from = display;
-    char *to = draw;
-    int bytes = ((fb_get_pitch() * fb_get_height())) ;
+    damage_rect_t rects[DAMAGE_MAX_RECTS];
+    int count = damage_take(&screen_damage, draw, rects);
+    int pitch = fb_get_pitch() / sizeof(color_t);
 
-    memcpy(to, from, bytes);
+    for (int i = 0; i < count; i++) {
+        int offset = rects[i].y*pitch + rects[i].x;
+        span_copy_rect((color_t *)draw + offset, pitch, (const color_t *)display + offset, pitch, rects[i].w, rects[i].h);
+    }
+}
 
+/* Notes that a region of the draw buffer was drawn, for screen_refresh(). */
+void screen_drawn(int x, int y, int w, int h) {
+    damage_add(&screen_damage, fb_get_draw_buffer(), x, y, w, h);
 }
 
 /*
@@ -158,6 +209,7 @@ void audio_play()
 updated contents (text) using functionality from gl and
 fb libraries. */
 void screen_refresh(void) {
+    render_draw(&playfield); // the playfield goes on screen with this swap, not one of its own
 
     char *display = fb_get_draw_buffer(); // get the address of the new display buf (post-swap)
     gl_swap_buffer(); // now, swap the buffers
@@ -167,96 +219,108 @@ void screen_refresh(void) {
     screen_copy_buffer(display, draw);
 }
 
-void check_and_clear_row(unsigned int row) {
+/* Animates a line clear: blanks the cleared rows, then scrolls the
+   rows above them down into their new place. */
+void draw_cleared_rows(unsigned int cleared, unsigned int count) {
     armtimer_disable();
-    
-    for (int shapeY = 0; shapeY < 4; shapeY++) {
-        if ((row + shapeY) >= NUM_ROWS) {
-            break;
-        }
 
-        unsigned int zeroinrow = 0;
+    timer_delay_ms(CLEAR_BLANK_MS);
 
-        for (int x = 0; x < NUM_COLS; x++) {
-            if (placedblocks[row + shapeY][x] == 0) {
-                zeroinrow = 1;
-                break;
-            }
-        }
-
-        if (zeroinrow == 0) {
-            timer_delay_ms(200);
-
-            rowscleared++;
-            draw_score();
-
-            for (int y = (row + shapeY); y > 0; y--) {
-                for (int x = 0; x < NUM_COLS; x++) {
-                    placedblocks[y][x] = placedblocks[y - 1][x];
-                }
-            }
+    draw_score();
 
+    // Blank out the cleared rows
+    for (unsigned int y = 0; y < NUM_ROWS; y++) {
+        if (cleared & (1u << y)) {
             for (int x = 0; x < NUM_COLS; x++) {
-                placedblocks[0][x] = 0;
+                render_cell(&playfield, x, y, RENDER_EMPTY);
             }
+        }
+    }
 
-            gl_draw_rect(PADDING_X, (row + shapeY)*BLOCK_SIZE + PADDING_Y,
-                    NUM_COLS*BLOCK_SIZE, BLOCK_SIZE, BACKGROUND_COLOR);
-
-            screen_refresh();
+    render_frame(&playfield);
 
-            timer_delay(1);
+    timer_delay_ms(CLEAR_SCROLL_MS);
 
-            gl_draw_rect(PADDING_X, PADDING_Y,
-                    NUM_COLS*BLOCK_SIZE, NUM_ROWS*BLOCK_SIZE, BACKGROUND_COLOR);
+    // The rows above scroll down over the cleared ones
+    render_clear_rows(&playfield, cleared);
+    render_frame(&playfield);
 
-            for (int x = 0; x < NUM_COLS; x++) {
-                for (int y = 0; y < NUM_ROWS; y++) {
-                    char blockshape = placedblocks[y][x];
-                    if (blockshape > 0) {
-                        color_t color = get_color(blockshape - 1);
-                        draw_block_once(x, y, color);
-                    }
-                }
-            }
+    if (game.rowscleared >= SPEED_ROWS && game.rowscleared - count < SPEED_ROWS) {
+        armtimer_init(ARM_TIMER_SPEED_US); 
+        interrupts_register_handler(INTERRUPTS_BASIC_ARM_TIMER_IRQ, timer_interrupt, NULL); 
+        interrupts_enable_source(INTERRUPTS_BASIC_ARM_TIMER_IRQ);
+        armtimer_enable_interrupts();
+    }
 
-            screen_refresh();
+    armtimer_enable();
+}
 
-            if (rowscleared == 5) {
-                armtimer_init(200000); 
-                interrupts_register_handler(INTERRUPTS_BASIC_ARM_TIMER_IRQ, timer_interrupt, NULL); 
-                interrupts_enable_source(INTERRUPTS_BASIC_ARM_TIMER_IRQ);
-                armtimer_enable_interrupts();
+/* Draws whatever the engine reports happened during one step, as a
+   single frame. */
+void draw_events(const event_t *events, int count) {
+    for (int i = 0; i < count; i++) {
+        const event_t *event = &events[i];
+
+        switch (event->type) {
+        case EVENT_MOVED:
+            armtimer_disable();
+            if (event->from.visible) {
+                render_shape(&playfield, event->from.x, event->from.y, event->from.shape, RENDER_EMPTY);
             }
+            if (event->to.visible) {
+                render_shape(&playfield, event->to.x, event->to.y, event->to.shape, event->to.shape.type + 1);
+            }
+            armtimer_enable();
+            break;
+        case EVENT_PLACED: // already drawn where it landed
+            break;
+        case EVENT_CLEARED:
+            draw_cleared_rows(event->cleared, event->count);
+            break;
+        case EVENT_SPAWNED:
+            get_and_update_next_shape();
+            break;
+        case EVENT_GAME_OVER:
+            if (!attract) loss_screen(); // tetris_run() starts the next demo game
+            break;
         }
     }
 
+    armtimer_disable();
+    render_frame(&playfield);
     armtimer_enable();
 }
 
+/* Streams a chunk of the replay log over the UART as one line of hex. */
+static void replay_uart(const unsigned char *bytes, int len) {
+    printf("@replay ");
+    for (int i = 0; i < len; i++) {
+        printf("%02x", bytes[i]);
+    }
+    printf("\n");
+}
+
+/* Feeds one input to the engine, logs it and draws the result. */
+void play_input(input_t input) {
+    event_t events[ENGINE_MAX_EVENTS];
+
+    // A gravity tick must not step the engine halfway through a key's step,
+    // and the log has to get the inputs in the order the engine did
+    armtimer_disable();
+    replay_record(&replaylog, input, ticks);
+    int count = engine_step(&game, input, events);
+    if (game.over) {
+        replay_finish(&replaylog, &game);
+    }
+    armtimer_enable();
+
+    draw_events(events, count);
+}
+
 /* Moves the shape down after being called by 
 the armtimer. */
 void gravity(void) {
-    if (valid_shape_position(currX, currY, currshape, placedblocks, NUM_ROWS, NUM_COLS)) {
-            if (currY != 0) {
-                clear_shape(currX, currY - 1, currshape);
-            }
-            draw_shape(currX, currY, currshape);
-            currY++;
-        } else if (currX == startingX && currY == 0) { // Game over!
-            loss_screen();
-        } else {
-            // We clear the last block and place the block in the placedblocks array
-            place_shape(currX, currY - 1, currshape, placedblocks, NUM_ROWS, NUM_COLS);
-            check_and_clear_row(currY - 1);
-
-            // reset the current position to the top of the game area
-            currY = 0;
-            currX = lastX = startingX;
-            currshape = nextshape;
-
-            get_and_update_next_shape();
-        }
+    play_input(INPUT_GRAVITY);
 }
 
 /* Sensor handler that is triggered consistently
@@ -268,22 +332,17 @@ void sensor_poll(void) {
         sensor_read(sensor); // read the sensor
         short x_accel = sensor_get_xAccel_Avg(sensor); // get the average of the x_accel rb
         short z_accel = sensor_get_zAccel_Avg(sensor); // get the average of the z_accel rb
-        
-        // update realY
-        if (currY == 0) {
-            realY = currY;
-        } else {
-            realY = currY - 1;
-        } 
 
         if (sensor_left(x_accel, sensor)) { 
             printf("left\n");
-            left_input();
+            if (attract) attract_tilted = true; // any tilt ends the demo
+            else left_input();
             coolDown = true;
         } 
         else if (sensor_right(x_accel, sensor)) {
             printf("right\n");
-            right_input();
+            if (attract) attract_tilted = true;
+            else right_input();
             coolDown = true;
         }
 
@@ -315,37 +374,60 @@ void sensor_poll(void) {
    Moves the blocks down. */
 void timer_interrupt(unsigned int pc, void *aux_data) { 
     if (armtimer_check_and_clear_interrupt()) {
+        ticks++;
         if (ARMCOUNTER == 0) {
-            gravity();
+            if (attract) attract_gravity_due = true;
+            else gravity();
             ARMCOUNTER = ARM_TIMER_START_COUNTER;
         } else {
             ARMCOUNTER--;
             sensor_poll();
         }
+
+        if (attract && ++attract_ticks >= ATTRACT_INPUT_TICKS) {
+            attract_ticks = 0;
+            attract_input_due = true;
+        }
     }
 }
 
 void draw_square_with_bound(int x, int y, int blocksize, color_t color) {
-        gl_draw_rect(x, y, // Fill out square
+        const tile_t *tile = tile_find(bound_tiles, NUM_SHAPES, blocksize, color);
+        if (tile) {
+            tile_blit(tile, x, y);
+            return;
+        }
+
+        span_fill_rect(x, y, // Fill out square
                 blocksize, blocksize, color);
-        gl_draw_rect(x, y, // Left
+        span_fill_rect(x, y, // Left
                 2, blocksize, GL_BLACK);
-        gl_draw_rect(x + blocksize - 2, y, // Right
+        span_fill_rect(x + blocksize - 2, y, // Right
                 2, blocksize, GL_BLACK);
-        gl_draw_rect(x, y, // Top
+        span_fill_rect(x, y, // Top
                 blocksize, 2, GL_BLACK);
-        gl_draw_rect(x, y + blocksize - 2, // Bottom
+        span_fill_rect(x, y + blocksize - 2, // Bottom
                 blocksize, 2, GL_BLACK);
 }
 
-void graphics_controls_init(input_fn_t read_fn) {
+void graphics_controls_init(input_fn_t read_fn, input_ready_fn_t ready_fn) {
     PADDING_X = 4*BLOCK_SIZE + 100;
     SCREEN_WIDTH = NUM_COLS*BLOCK_SIZE + 2*PADDING_X;
     SCREEN_HEIGHT = NUM_ROWS*BLOCK_SIZE + 2*PADDING_Y;
 
     gl_init(SCREEN_WIDTH, SCREEN_HEIGHT, GL_DOUBLEBUFFER);
+    render_init(&playfield, PADDING_X, PADDING_Y, BLOCK_SIZE, BACKGROUND_COLOR, COLOR);
+    damage_init(&screen_damage, SCREEN_WIDTH, SCREEN_HEIGHT);
+    for (int type = 0; type < NUM_SHAPES; type++) {
+        tile_square(&bound_tiles[type], BLOCK_SIZE, 2, COLOR[type]);
+    }
     controls_read = read_fn;
-
+    controls_ready = ready_fn;
+    engine_init(&game, PIECE_MODE);
+    tt_init(&bot_tt, bot_tt_memory, sizeof(bot_tt_memory));
+    beam_init(&bot_planner, bot_planner_nodes, sizeof(bot_planner_nodes) / sizeof(bot_planner_nodes[0]),
+              BOT_BEAM_WIDTH, BOT_BEAM_DEPTH);
+    beam_budget(&bot_planner, timer_get_ticks, BOT_BEAM_US); // the system timer counts microseconds
 }
 
 void write_title(void) {
@@ -445,22 +527,51 @@ void write_title(void) {
     const char *text4 = "Nick Reisner, Sebastian Russo, and Devon Smith";
     gl_draw_string(center_text(text4), 5*3 + gapY*1 + titleblocksize*7 + gl_get_char_height()*3, text4, GL_BLACK);
 
-    // const char *text5 = "Press Any Key To Play!";
-    const char *text5 = "Wait 5 Seconds To Play!";
+    const char *text5 = "Press Any Key Or Tilt To Play!";
     gl_draw_string(center_text(text5), 5*4 + gapY*1 + titleblocksize*8 + gl_get_char_height()*4, text5, GL_BLACK);
 }
 
 
 void start_screen(void)
 {
-    gl_clear(BACKGROUND_COLOR);
+    span_fill_rect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BACKGROUND_COLOR);
     write_title();
     gl_swap_buffer();
     audio_play();
-    // controls_read(); 
-    timer_delay(5);
+    timer_delay(ATTRACT_TITLE_SECONDS);
+
+    // The bot cannot end a demo of its own, so it goes straight to a game
+    if (controls_read == bot_read_next) {
+        tetris_init();
+    } else {
+        attract_start();
+    }
+}
+
+void attract_start(void) {
+    armtimer_disable();
+    if (attract) { // a soak test of the renderer as much as a demo, so say how it went
+        printf("demo over: %u rows in %u pieces\n", game.rowscleared, game.spawned);
+    } else {
+        attract_best = game.mostrows;
+    }
+    game.mostrows = attract_best;
+
+    beam_budget(&bot_planner, timer_get_ticks, ATTRACT_BEAM_US);
+    attract_ticks = 0;
+    attract_gravity_due = false;
+    attract_input_due = false;
+    attract_tilted = false;
+    attract = true;
+    tetris_init();
+}
+
+void attract_stop(void) {
+    armtimer_disable();
+    attract = false;
+    game.mostrows = attract_best;
+    beam_budget(&bot_planner, timer_get_ticks, BOT_BEAM_US);
 
-    
     tetris_init();
 }
 
@@ -468,12 +579,8 @@ void loss_screen(void)
 {
     armtimer_disable();
 
-    if (rowscleared > mostrows) {
-        mostrows = rowscleared;
-    }
-
     unsigned int blockpadding = 1;
-    gl_draw_rect(PADDING_X + BLOCK_SIZE*blockpadding,  
+    span_fill_rect(PADDING_X + BLOCK_SIZE*blockpadding,  
             PADDING_Y + BLOCK_SIZE*blockpadding,
             BLOCK_SIZE*(NUM_COLS - blockpadding*2),
             BLOCK_SIZE*(NUM_ROWS - blockpadding*2), 
@@ -482,26 +589,25 @@ void loss_screen(void)
     const char *text = "GAME OVER!";
     gl_draw_string(center_text(text), PADDING_Y + BLOCK_SIZE*blockpadding + 5, text, GL_BLACK);
 
-    // const char *text2 = "Press any key to play again.";
-    const char *text2 = "Wait ten seconds to play again.";
+    const char *text2 = "Press any key to play again.";
     gl_draw_string(center_text(text2), PADDING_Y + BLOCK_SIZE*blockpadding + gl_get_char_height() + 8, text2, GL_BLACK);
 
-    gl_draw_rect(PADDING_X - BORDER_THICKNESS + BLOCK_SIZE*blockpadding, // Left 
+    span_fill_rect(PADDING_X - BORDER_THICKNESS + BLOCK_SIZE*blockpadding, // Left 
             PADDING_Y - BORDER_THICKNESS + BLOCK_SIZE*blockpadding,
             BORDER_THICKNESS,
             BLOCK_SIZE*(NUM_ROWS - blockpadding*2) + BORDER_THICKNESS,
             BORDER_COLOR);
-    gl_draw_rect(SCREEN_WIDTH - PADDING_X - BLOCK_SIZE*blockpadding, // Right
+    span_fill_rect(SCREEN_WIDTH - PADDING_X - BLOCK_SIZE*blockpadding, // Right
             PADDING_Y - BORDER_THICKNESS + BLOCK_SIZE*blockpadding,
             BORDER_THICKNESS,
             BLOCK_SIZE*(NUM_ROWS - blockpadding*2) + BORDER_THICKNESS,
             BORDER_COLOR);
-    gl_draw_rect(PADDING_X - BORDER_THICKNESS + BLOCK_SIZE*blockpadding, // Top
+    span_fill_rect(PADDING_X - BORDER_THICKNESS + BLOCK_SIZE*blockpadding, // Top
             PADDING_Y - BORDER_THICKNESS + BLOCK_SIZE*blockpadding,
             BLOCK_SIZE*(NUM_COLS - blockpadding*2) + BORDER_THICKNESS,
             BORDER_THICKNESS,
             BORDER_COLOR);
-    gl_draw_rect(PADDING_X - BORDER_THICKNESS + BLOCK_SIZE*blockpadding, // Bottom
+    span_fill_rect(PADDING_X - BORDER_THICKNESS + BLOCK_SIZE*blockpadding, // Bottom
             SCREEN_HEIGHT - PADDING_Y - BLOCK_SIZE*blockpadding,
             BLOCK_SIZE*(NUM_COLS - blockpadding*2) + BORDER_THICKNESS,
             BORDER_THICKNESS,
@@ -519,23 +625,23 @@ void loss_screen(void)
 // Initializes the background and draws the background color and game border 
 void background_init(void)
 {
-    gl_clear(BACKGROUND_COLOR);
-    gl_draw_rect(PADDING_X - BORDER_THICKNESS, // Left 
+    span_fill_rect(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BACKGROUND_COLOR);
+    span_fill_rect(PADDING_X - BORDER_THICKNESS, // Left 
             PADDING_Y - BORDER_THICKNESS,
             BORDER_THICKNESS,
             SCREEN_HEIGHT - PADDING_Y*2 + BORDER_THICKNESS, 
             BORDER_COLOR);
-    gl_draw_rect(SCREEN_WIDTH - PADDING_X, // Right
+    span_fill_rect(SCREEN_WIDTH - PADDING_X, // Right
             PADDING_Y - BORDER_THICKNESS,
             BORDER_THICKNESS,
             SCREEN_HEIGHT - PADDING_Y*2 + BORDER_THICKNESS, 
             BORDER_COLOR);
-    gl_draw_rect(PADDING_X - BORDER_THICKNESS, // Top
+    span_fill_rect(PADDING_X - BORDER_THICKNESS, // Top
             PADDING_Y - BORDER_THICKNESS,
             SCREEN_WIDTH - PADDING_X*2 + BORDER_THICKNESS*2, 
             BORDER_THICKNESS,
             BORDER_COLOR);
-    gl_draw_rect(PADDING_X - BORDER_THICKNESS, // Bottom
+    span_fill_rect(PADDING_X - BORDER_THICKNESS, // Bottom
             SCREEN_HEIGHT - PADDING_Y,
             SCREEN_WIDTH - PADDING_X*2 + BORDER_THICKNESS*2, 
             BORDER_THICKNESS,
@@ -543,7 +649,9 @@ void background_init(void)
 
     score_init();
     next_block_init();
-    screen_refresh();
+    screen_drawn(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+    render_reset(&playfield, &game.board); // the empty board, drawn with the rest
+    screen_refresh(); // the other buffer still shows the last screen until it gets this copied
 }
 
 void score_init(void) {
@@ -552,66 +660,51 @@ void score_init(void) {
     gl_draw_string(SCORE_X, SCORE_Y - gl_get_char_height() - 3, "SCORE", GL_BLACK);
     gl_draw_string(SCORE_X, SCORE_Y + gl_get_char_height() + 10, "HIGH SCORE", GL_BLACK);
 
-    rowscleared = 0;
     score[SCORE_DIGITS] = '\0';
-    snprintf(score, SCORE_DIGITS + 1, "%05d", rowscleared);
+    snprintf(score, SCORE_DIGITS + 1, "%05d", game.rowscleared);
 
     highscore[SCORE_DIGITS] = '\0';
-    snprintf(highscore, SCORE_DIGITS + 1, "%05d", mostrows);
+    snprintf(highscore, SCORE_DIGITS + 1, "%05d", game.mostrows);
 
     gl_draw_string(SCORE_X, SCORE_Y, score, GL_BLACK);
     gl_draw_string(SCORE_X, SCORE_Y + gl_get_char_height()*2 + 13, highscore, GL_BLACK);
 }
 
 void next_block_init(void) {
-    nextshape = random_start_shape();
     draw_square_with_bound(SCORE_X, SCREEN_HEIGHT/2 - BLOCK_SIZE*2, BLOCK_SIZE*4 + 10, BACKGROUND_COLOR);
-    draw_shape_raw(SCORE_X + 5, SCREEN_HEIGHT/2 - BLOCK_SIZE*1 + 10, nextshape, BLOCK_SIZE);
+    draw_shape_raw(SCORE_X + 5, SCREEN_HEIGHT/2 - BLOCK_SIZE*1 + 10, game.next, BLOCK_SIZE);
     gl_draw_string(SCORE_X, SCREEN_HEIGHT/2 - BLOCK_SIZE*2 - gl_get_char_height() - 5, "NEXT BLOCK", GL_BLACK);
 }
 
 void get_and_update_next_shape(void) {
-    nextshape = random_start_shape();
-
-    gl_draw_rect(SCORE_X + 5, SCREEN_HEIGHT/2 - BLOCK_SIZE*2 + 5,
+    span_fill_rect(SCORE_X + 5, SCREEN_HEIGHT/2 - BLOCK_SIZE*2 + 5,
                 BLOCK_SIZE*4, BLOCK_SIZE*4, BACKGROUND_COLOR);
-    draw_shape_raw(SCORE_X + 5, SCREEN_HEIGHT/2 - BLOCK_SIZE*1 + 10, nextshape, BLOCK_SIZE);
+    draw_shape_raw(SCORE_X + 5, SCREEN_HEIGHT/2 - BLOCK_SIZE*1 + 10, game.next, BLOCK_SIZE);
 
-    gl_swap_buffer();
-
-    gl_draw_rect(SCORE_X + 5, SCREEN_HEIGHT/2 - BLOCK_SIZE*2 + 5,
-                BLOCK_SIZE*4, BLOCK_SIZE*4, BACKGROUND_COLOR);
-    draw_shape_raw(SCORE_X + 5, SCREEN_HEIGHT/2 - BLOCK_SIZE*1 + 10, nextshape, BLOCK_SIZE);
+    // The box, and the shape in case it sticks out of it
+    const shape_info_t *info = shape_info(game.next);
+    screen_drawn(SCORE_X + 5, SCREEN_HEIGHT/2 - BLOCK_SIZE*2 + 5, BLOCK_SIZE*4, BLOCK_SIZE*4);
+    screen_drawn(SCORE_X + 5 + info->left*BLOCK_SIZE, SCREEN_HEIGHT/2 - BLOCK_SIZE*1 + 10 + info->top*BLOCK_SIZE,
+            (info->right - info->left + 1)*BLOCK_SIZE, (info->bottom - info->top + 1)*BLOCK_SIZE);
+    screen_refresh();
 }
 
 
-/* Initializes the 2D-array that tracks the location of placed bricks */
-void placedblocks_init(void) {
-
-    placedblocks = malloc(sizeof(char*)*NUM_ROWS); // Allocate memory for the columns
-
-    for (int y = 0; y < NUM_ROWS; y++) { // Allocate memory for the rows
-        placedblocks[y] = malloc(sizeof(char)*NUM_COLS);
-    }
-
-    for (int y = 0; y < NUM_ROWS; y++) { // Initialize the array to 0
-        for (int x = 0; x < NUM_COLS; x++) {
-            placedblocks[y][x] = 0;
-        }
-    }
-}
-
 /* Initializes tetris graphics and mechanics
-   objects -- background and placedblocks array. */
+   objects -- a new game in the engine and the background. */
 void tetris_init(void) {
-    currshape = random_start_shape();
-    startingX = (NUM_COLS / 2) - 2;
-    currX = lastX = startingX;
-    currY = 0;
+    // Every game gets its own seed, which is all it takes to deal its shapes again
+    unsigned int seed = timer_get_ticks();
+    printf("seed %u\n", seed);
+    engine_new_game(&game, seed);
+    bot_init(&bot, &BOT_WEIGHTS);
+    bot_lookahead(&bot, BOT_DEPTH, &bot_tt);
+    if (BOT_BEAM_WIDTH > 0) bot_beam(&bot, &bot_planner);
+    replay_abort(&replaylog); // a demo or game left before it ended
+    replay_start(&replaylog, replay_uart, &game, ticks);
 
     background_init();
-    placedblocks_init();
-    armtimer_init(50000); // one mag less for sensor implementation
+    armtimer_init(ARM_TIMER_START_US); // one mag less for sensor implementation
 
     interrupts_register_handler(INTERRUPTS_BASIC_ARM_TIMER_IRQ, timer_interrupt, NULL); 
     interrupts_enable_source(INTERRUPTS_BASIC_ARM_TIMER_IRQ);
@@ -619,95 +712,55 @@ void tetris_init(void) {
     armtimer_enable();
 }
 
-/* Draws a block at a particular (x,y). This (x,y) corresponds to
-   the game grid, not pixels. */
-void draw_block_once(unsigned int x, unsigned int y, color_t color) {
-    if (x >= 0 && x < NUM_COLS && y >= 0 && y < NUM_ROWS) {
-        gl_draw_rect(x*BLOCK_SIZE + PADDING_X, y*BLOCK_SIZE + PADDING_Y, // Fill out square
-                BLOCK_SIZE, BLOCK_SIZE, color);
-        gl_draw_rect(x*BLOCK_SIZE + PADDING_X, y*BLOCK_SIZE + PADDING_Y, // Left
-                1, BLOCK_SIZE, GL_BLACK);
-        gl_draw_rect(x*BLOCK_SIZE + BLOCK_SIZE - 1 + PADDING_X, y*BLOCK_SIZE + PADDING_Y, // Right
-                1, BLOCK_SIZE, GL_BLACK);
-        gl_draw_rect(x*BLOCK_SIZE + PADDING_X, y*BLOCK_SIZE + PADDING_Y, // Top
-                BLOCK_SIZE, 1, GL_BLACK);
-        gl_draw_rect(x*BLOCK_SIZE + PADDING_X, y*BLOCK_SIZE + BLOCK_SIZE - 1 + PADDING_Y, // Bottom
-                BLOCK_SIZE, 1, GL_BLACK);
-    }
-}
-
-/* Draws block as desribed in above fucntion for both bufs. */
-void draw_block(unsigned int x, unsigned int y, color_t color) {
-    draw_block_once(x, y, color); // draw in draw buf
-    gl_swap_buffer(); // swap buf and draw in draw buf
-    draw_block_once(x, y, color); // draw in new buf
-}
-
-/* Clears a block at a particular (x,y). This (x,y) corresponds to the 
-   game grid, not pixels. Updates a single buffer. */
-void clear_block_once(unsigned int x, unsigned int y) {
-    if (x >= 0 && x < NUM_COLS && y >= 0 && y < NUM_ROWS) {
-        gl_draw_rect(x*BLOCK_SIZE + PADDING_X, y*BLOCK_SIZE + PADDING_Y,
-                BLOCK_SIZE, BLOCK_SIZE, BACKGROUND_COLOR);
-    }
-}
-
-/* Clears both as described in above function for both bufs. */
-void clear_block(unsigned int x, unsigned int y) {
-    clear_block_once(x, y); // clear the block in the draw buffer
-    gl_swap_buffer(); // swap the buffers
-    clear_block_once(x, y); // clear the block in the new buffer
-}
-
-
 /* Input - 'a' / left-movement */
 void left_input(void) {
-    if (valid_shape_position(currX - 1, realY, currshape, placedblocks, NUM_ROWS, NUM_COLS)) {
-            clear_shape(currX, realY, currshape);
-            currX--;
-            if (realY == (currY - 1)) draw_shape(currX, realY, currshape);
-        }
+    play_input(INPUT_LEFT);
 }
 
 /* Input - 'd' / right movement */
 void right_input(void) {
-    if (valid_shape_position(currX + 1, realY, currshape, placedblocks, NUM_ROWS, NUM_COLS)) {
-            clear_shape(currX, realY, currshape);
-            currX++;
-            if (realY == (currY - 1)) draw_shape(currX, realY, currshape);
-        }
+    play_input(INPUT_RIGHT);
 }
 
 /* Input - 's' / down movement */
 void down_input(void) {
-        if (valid_shape_position(currX, currY, currshape, placedblocks, NUM_ROWS, NUM_COLS)) {
-            clear_shape(currX, realY, currshape);
-            draw_shape(currX, currY, currshape);
-            currY++;
-        }
+    play_input(INPUT_DOWN);
 }
 
 /* Input - 'w' / up movement */
 void rotate_input(void) {
-    shape_t potentialshape = get_next_orientation(currshape);
-    if (valid_shape_position(currX, realY, potentialshape, placedblocks, NUM_ROWS, NUM_COLS)) {
-        clear_shape(currX, realY, currshape);
-        if (realY == (currY - 1)) draw_shape(currX, realY, potentialshape);
-        currshape = potentialshape;
+    play_input(INPUT_ROTATE);
+}
+
+/* Plays the game: returns the key for the bot's next input, at the
+   pace of a quick human player. */
+unsigned char bot_read_next(void) {
+    timer_delay_ms(BOT_INPUT_MS);
+
+    switch (bot_next_input(&bot, &game)) {
+    case INPUT_LEFT:
+        return 'a';
+    case INPUT_RIGHT:
+        return 'd';
+    case INPUT_ROTATE:
+        return 'w';
+    default:
+        return 's';
     }
 }
 
+/* The bot always has its next input ready. */
+bool bot_has_next(void) {
+    return true;
+}
+
 /* Reads the input for the game! */
 void read_input(void) {
+    while (!controls_ready()) {
+        if (attract) return; // a lost game went back to the demo
+    }
     unsigned char next = controls_read();
 
-    // Note: currY global is always one ahead of the drawn position of the block
-    if (currY == 0) {
-        realY = currY;
-    } else {
-        realY = currY - 1;
-    } 
-   
     if (next == 'a') {
         left_input();
     } 
@@ -722,32 +775,48 @@ void read_input(void) {
     }
 }
 
+/* Private helper that plays what the armtimer marked due in the demo,
+   starts the next demo when one ends and ends it on a key or tilt. */
+static void attract_step(void) {
+    if (attract_tilted || controls_ready()) {
+        if (!attract_tilted) controls_read(); // the key only ends the demo
+        attract_stop();
+        return;
+    }
+
+    if (attract_gravity_due) {
+        attract_gravity_due = false;
+        gravity();
+    }
+    if (attract_input_due && !game.over) {
+        attract_input_due = false;
+        play_input(bot_next_input(&bot, &game));
+    }
+    if (game.over) {
+        attract_start(); // on to the next demo game
+    }
+}
+
 /* Main game loop */
 void tetris_run(void) {
     while (1) {
-        read_input();
+        if (attract) attract_step();
+        else read_input();
     }
 }
 
 void draw_score(void) {
-    snprintf(score, SCORE_DIGITS + 1, "%05d", rowscleared);
+    snprintf(score, SCORE_DIGITS + 1, "%05d", game.rowscleared);
 
-    gl_draw_rect(SCORE_X, SCORE_Y, gl_get_char_width()*5, gl_get_char_height(), BACKGROUND_COLOR);
+    span_fill_rect(SCORE_X, SCORE_Y, gl_get_char_width()*5, gl_get_char_height(), BACKGROUND_COLOR);
     gl_draw_string(SCORE_X, SCORE_Y, score, GL_BLACK);
 
-    gl_swap_buffer();
-
-    gl_draw_rect(SCORE_X, SCORE_Y, gl_get_char_width()*5, gl_get_char_height(), BACKGROUND_COLOR);
-    gl_draw_string(SCORE_X, SCORE_Y, score, GL_BLACK);
+    screen_drawn(SCORE_X, SCORE_Y, gl_get_char_width()*5, gl_get_char_height());
+    screen_refresh();
 }
 
 int lowest_spot(void) {
-    int tempY = currY - 1;
-    while (valid_shape_position(currX, tempY, currshape, placedblocks, NUM_ROWS, NUM_COLS)) {
-        tempY++;
-    }
-
-    return (tempY - 1);
+    return board_drop_row(&game.board, game.curr.x, game.curr.y, shape_info(game.curr.shape));
 }
 
 unsigned int center_text(const char *text) {
@@ -1,8 +1,10 @@
 #ifndef _MY_MODULE_H
 #define _MY_MODULE_H
 
+#include <stdbool.h>
 #include "gl.h"
 #include "shapes.h"
+#include "engine.h"
 
 /* Module to unite the Tetris graphics with the gameplay 
 mechanics taking in arm_timer interrupts and ps2_interrupts. 
@@ -26,19 +28,36 @@ Last Update: 12/13/2022
  */
 typedef unsigned char (*input_fn_t)(void);
 
+/*
+ * Type: `input_ready_fn_t`
+ *
+ * Goes with an input_fn_t: returns whether it has an input waiting, so
+ * a read would not block. The demo game plays on until it returns true.
+ */
+typedef bool (*input_ready_fn_t)(void);
+
 void sensor_dev_init(void);
 
 /* 'screen_copy_buffer'
 
 Copies one fb to the other fb when doublebuffering.
-For updating the non-drawn display.
+For updating the non-drawn display: only the regions it
+has missed since it was last updated.
 */
 void screen_copy_buffer(char *display, char *draw);
 
+/* 'screen_drawn'
+
+Records a region just drawn in the draw buffer, for screen_refresh()
+to copy into the other one.
+*/
+void screen_drawn(int x, int y, int w, int h);
+
 /* 'screen_refresh'
 
 Refreshes the screen by swapping the buffers and calling
-screen_copy_buffer to update the non-drawn display.
+screen_copy_buffer to update the non-drawn display
+with the regions recorded by screen_drawn().
 */
 void screen_refresh(void);
 
@@ -55,6 +74,25 @@ Moves the block down based on armtimer init val
 and ARM_TIMER_START_COUNTER */
 void gravity(void);
 
+/* 'play_input'
+
+Feeds one input to the game engine and draws the events it reports.
+*/
+void play_input(input_t input);
+
+/* 'draw_events'
+
+Draws the events reported by one engine step.
+*/
+void draw_events(const event_t *events, int count);
+
+/* 'draw_cleared_rows'
+
+Animates a line clear of the rows set in 'cleared' and scrolls the
+board above them down.
+*/
+void draw_cleared_rows(unsigned int cleared, unsigned int count);
+
 /* 'timer_interrupt'
 
 Handler for arm_timer interrupt events. 
@@ -68,16 +106,45 @@ void timer_interrupt(unsigned int pc, void *aux_data);
 
 /* 'graphics_controls_init'
 
-Initializes graphics and controls input.
+Initializes graphics and controls input: 'read_fn' reads the next
+input and 'ready_fn' says whether one is waiting.
+*/
+void graphics_controls_init(input_fn_t read_fn, input_ready_fn_t ready_fn);
+
+/* 'bot_read_next'
+
+An input function that lets the computer player play: pass it to
+graphics_controls_init() instead of keyboard_read_next.
+*/
+unsigned char bot_read_next(void);
+
+/* 'bot_has_next'
+
+The ready function that goes with bot_read_next(): the bot always has
+an input to make.
 */
-void graphics_controls_init(input_fn_t read_fn);
+bool bot_has_next(void);
 
 /* 'start_screen'
 
-Start screen graphics and waits for key input.
+Start screen graphics, then a demo game until key or glove input.
 */
 void start_screen(void);
 
+/* 'attract_start'
+
+Starts a demo game the bot plays by itself, until attract_stop().
+The armtimer only marks its steps due and tetris_run() plays them, so
+a key or tilt of the glove stops it as soon as the step is done.
+*/
+void attract_start(void);
+
+/* 'attract_stop'
+
+Ends the demo game and starts a real one.
+*/
+void attract_stop(void);
+
 /* 'loss_screen'
 
 Loss screen graphics and waits for key input.
@@ -86,7 +153,7 @@ void loss_screen(void);
 
 /* 'get_and_update_next_shape'
 
-Gets a new shape and takes care of graphics for next shape.
+Takes care of graphics for the new next shape.
 */
 void get_and_update_next_shape(void);
 
@@ -108,15 +175,9 @@ Initializes the next block graphics.
 */
 void next_block_init(void);
 
-/* 'placedblocks_init' 
-
-Initializes the array of placed blocks. 
-*/
-void placedblocks_init(void);
-
 /* 'tetris_init
 
-Initializes placedblocks, background, and controls inputs.
+Starts a new game and initializes the background and timer.
 */
 void tetris_init(void);
 
@@ -126,30 +187,6 @@ Draws a block square with a black boundary at the x and y given.
 */
 void draw_square_with_bound(int x, int y, int blocksize, color_t color);
 
-/* 'draw_block_once'
-
-Draws a block at the given x and y coordinates in one buffer.
-*/
-void draw_block_once(unsigned int x, unsigned int y, color_t color);
-
-/* 'draw_block'
-
-Draws a block at the given x and y coordinates in both buffers.
-*/
-void draw_block(unsigned int x, unsigned int y, color_t color);
-
-/* 'clear_block_once'
-
-Clears a block at the given x and y coordinates in one buffer.
-*/
-void clear_block_once(unsigned int x, unsigned int y);
-
-/* 'clear_block'
-
-Clears a block at the given x and y coordinates in both buffers.
-*/
-void clear_block(unsigned int x, unsigned int y);
-
 /* 'left_input'
 
 Manages left inputs and adjusts blocks.
@@ -176,13 +213,14 @@ void rotate_input(void);
 
 /* 'read_input'
 
-Manages inputs and adjusts blocks.
+Manages inputs and adjusts blocks. Returns without one if the game
+goes back to the demo while it waits.
 */
 void read_input(void);
 
 /* 'tetris_run'
 
-Runs the game.
+Runs the game, or the demo steps the armtimer has marked due.
 */
 void tetris_run(void);
 
@@ -10,6 +10,9 @@
 #include "printf.h"
 #include "sensor.h"
 #include "i2c.h"
+#include "timing.h"
+
+#define BOT_PLAYS 0 // 1 to watch the computer player instead of playing
 
 void main(void)
 {
@@ -23,14 +26,15 @@ void main(void)
     sensor_dev_init(); // for sensor
 
     // Enable armtimer interrupts and initialize the timer [changed for sensor polling]
-    armtimer_init(50000);
+    armtimer_init(ARM_TIMER_START_US);
     interrupts_register_handler(INTERRUPTS_BASIC_ARM_TIMER_IRQ, timer_interrupt, NULL); 
     interrupts_enable_source(INTERRUPTS_BASIC_ARM_TIMER_IRQ);
 
     interrupts_global_enable(); 
     armtimer_enable_interrupts();
 
-    graphics_controls_init(keyboard_read_next);
+    graphics_controls_init(BOT_PLAYS ? bot_read_next : keyboard_read_next,
+                           BOT_PLAYS ? bot_has_next : keyboard_has_next);
     start_screen();
     tetris_run();
 
@@ -0,0 +1,112 @@
+#include "reach.h"
+
+#define WALLS_BEYOND 0xFFFF0000u // board rows read as 32 bits are solid past the right wall
+
+/* Private helper that works out, for every orientation and row, the x
+   positions the shape fits at. */
+static void find_fits(reach_t *reach, const board_t *board, int type) {
+    for (int o = 0; o < NUM_ORIENTATIONS; o++) {
+        shape_t shape = {type, o};
+        const shape_info_t *info = shape_info(shape);
+
+        for (int y = 0; y < NUM_ROWS; y++) {
+            if (y + info->top < 0 || y + info->bottom >= NUM_ROWS) {
+                reach->fits[o][y] = 0;
+                continue;
+            }
+
+            // A cell in map column c collides at x wherever the board has bit x + c set
+            unsigned int blocked = 0;
+            for (int mapY = info->top; mapY <= info->bottom; mapY++) {
+                unsigned int row = board->rows[y + mapY] | WALLS_BEYOND;
+                for (int c = 0; c < 4; c++) {
+                    if ((info->masks[mapY] >> c) & 1) blocked |= row >> c;
+                }
+            }
+            reach->fits[o][y] = ~blocked;
+        }
+    }
+}
+
+/* Private helper that returns 1 if the shape fits in 'orientation' at
+   x index 'i' (x + BOARD_WALL) of row y. */
+static inline int fits(const reach_t *reach, int o, int i, int y) {
+    return i >= 0 && i < REACH_WIDTH && y < NUM_ROWS && ((reach->fits[o][y] >> i) & 1);
+}
+
+int reach_search(reach_t *reach, const board_t *board, const piece_t *piece) {
+    unsigned short queue[REACH_STATES];
+    int head = 0, tail = 0, landings = 0;
+
+    find_fits(reach, board, piece->shape.type);
+    for (int w = 0; w < REACH_WORDS; w++) {
+        reach->visited[w] = 0;
+        reach->landed[w] = 0;
+    }
+    reach->expanded = 0;
+
+    int o = piece->shape.orientation;
+    if (piece->y < 0 || !fits(reach, o, piece->x + BOARD_WALL, piece->y)) {
+        reach->start = 0;
+        return 0;
+    }
+
+    reach->start = reach_state(o, piece->x, piece->y);
+    reach->visited[reach->start / 32] |= 1u << (reach->start % 32);
+    queue[tail++] = reach->start;
+
+    while (head < tail) {
+        unsigned int state = queue[head++];
+        int i = state % REACH_WIDTH;
+        int y = (state / REACH_WIDTH) % NUM_ROWS;
+        o = state / (REACH_WIDTH * NUM_ROWS);
+        reach->expanded++;
+
+        // The next gravity tick places a shape that cannot move down, so
+        // a path never goes on from there
+        if (!fits(reach, o, i, y + 1)) {
+            reach->landed[state / 32] |= 1u << (state % 32);
+            landings++;
+            continue;
+        }
+
+        // Moving down comes last, so among the shortest paths the one that
+        // turns and slides early is found first: gravity cannot spoil it
+        struct { int o, i, y; input_t input; } next[4] = {
+            {o, i - 1, y, INPUT_LEFT},
+            {o, i + 1, y, INPUT_RIGHT},
+            {(o + 1) % NUM_ORIENTATIONS, i, y, INPUT_ROTATE},
+            {o, i, y + 1, INPUT_DOWN},
+        };
+        for (int m = 0; m < 4; m++) {
+            if (!fits(reach, next[m].o, next[m].i, next[m].y)) continue;
+
+            unsigned int to = (next[m].o * NUM_ROWS + next[m].y) * REACH_WIDTH + next[m].i;
+            if (reach_has(reach->visited, to)) continue;
+
+            reach->visited[to / 32] |= 1u << (to % 32);
+            reach->parent[to] = state;
+            reach->move[to] = next[m].input;
+            queue[tail++] = to;
+        }
+    }
+
+    return landings;
+}
+
+int reach_path(const reach_t *reach, unsigned int state, input_t path[REACH_MAX_PATH]) {
+    int len = 0;
+    for (unsigned int s = state; s != reach->start; s = reach->parent[s]) {
+        len++;
+    }
+    if (len > REACH_MAX_PATH) {
+        return -1;
+    }
+
+    // Walk back from the end, filling the path in from the back
+    int at = len;
+    for (unsigned int s = state; s != reach->start; s = reach->parent[s]) {
+        path[--at] = (input_t)reach->move[s];
+    }
+    return len;
+}
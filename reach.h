@@ -0,0 +1,85 @@
+#ifndef REACH_H
+#define REACH_H
+
+#include "engine.h"
+
+/* Module to find every spot the shape in play can reach with the real
+controls: rotating, sliding and moving down, in any order. Besides the
+straight drops this finds tucks and slides under overhangs after moving
+part of the way down.
+
+The search is a breadth-first search over (orientation, y, x) states
+with the same rules as engine_step(): a move is allowed when the shape
+fits where it ends up. Before it starts, it works out for every
+orientation and row at which x positions the shape fits, a whole row of
+candidates at once: every filled cell of the shape shifts the board row
+it lands on, and the union of those shifts is where it collides. Each
+state then costs one bit test per move.
+
+A state is landed when the shape cannot move down from it, which is
+where the next gravity tick would place it. The engine has no lock
+delay, so the search does not move on from a landed state: slides along
+the stack only count while the shape is still free to fall. Since the
+search is breadth-first, the recorded path to every state is a shortest
+one.
+Paths are written as if the shape were visible already; the first down
+input only brings a hidden shape onto the screen.
+*/
+
+#define REACH_WIDTH 16 // x positions per row of states, x + BOARD_WALL
+#define REACH_STATES (NUM_ORIENTATIONS * NUM_ROWS * REACH_WIDTH)
+#define REACH_WORDS (REACH_STATES / 32)
+#define REACH_MAX_PATH 64
+
+typedef struct {
+    unsigned short fits[NUM_ORIENTATIONS][NUM_ROWS]; // bit x + BOARD_WALL set where the shape fits
+    unsigned int visited[REACH_WORDS]; // states the shape can reach
+    unsigned int landed[REACH_WORDS]; // reachable states it cannot move down from
+    unsigned short parent[REACH_STATES]; // state each reached state was first reached from
+    unsigned char move[REACH_STATES]; // input_t that got it there
+    unsigned int start; // state the search started in
+    int expanded; // states taken off the queue
+} reach_t;
+
+/* 'reach_state'
+
+Returns the state for the shape in 'orientation' at (x, y).
+*/
+static inline unsigned int reach_state(int orientation, int x, int y) {
+    return (orientation * NUM_ROWS + y) * REACH_WIDTH + x + BOARD_WALL;
+}
+
+/* 'reach_unpack'
+
+Turns a state back into its orientation and position.
+*/
+static inline void reach_unpack(unsigned int state, int *orientation, int *x, int *y) {
+    *x = (int)(state % REACH_WIDTH) - BOARD_WALL;
+    *y = (state / REACH_WIDTH) % NUM_ROWS;
+    *orientation = state / (REACH_WIDTH * NUM_ROWS);
+}
+
+/* 'reach_has'
+
+Returns nonzero if 'state' is set in the bitset 'bits'.
+*/
+static inline unsigned int reach_has(const unsigned int *bits, unsigned int state) {
+    return (bits[state / 32] >> (state % 32)) & 1;
+}
+
+/* 'reach_search'
+
+Finds every state the piece can reach on the board. Returns the number
+of landed states, which are set in reach->landed.
+*/
+int reach_search(reach_t *reach, const board_t *board, const piece_t *piece);
+
+/* 'reach_path'
+
+Writes the inputs that take the shape from the start of the search to
+'state', which must have been reached, into 'path'. Returns how many
+inputs there are, or -1 if there are more than REACH_MAX_PATH.
+*/
+int reach_path(const reach_t *reach, unsigned int state, input_t path[REACH_MAX_PATH]);
+
+#endif
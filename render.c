@@ -0,0 +1,222 @@
+#include "render.h"
+#include "fb.h"
+#include "span.h"
+
+void render_init(render_t *render, int left, int top, int block, color_t background, const color_t *colors) {
+    render->left = left;
+    render->top = top;
+    render->block = block;
+    tile_square(&render->tiles[RENDER_EMPTY], block, 0, background);
+    for (int type = 0; type < NUM_SHAPES; type++) {
+        tile_square(&render->tiles[type + 1], block, 1, colors[type]);
+    }
+    render->buffers[0] = render->buffers[1] = 0;
+    render->dirty = 0;
+    render_reset(render, 0);
+
+    render_stats_t none = {0};
+    render->stats = none;
+}
+
+void render_reset(render_t *render, const board_t *board) {
+    for (int y = 0; y < NUM_ROWS; y++) {
+        for (int x = 0; x < NUM_COLS; x++) {
+            render->cells[y][x] = board ? board_cell(board, x, y) : RENDER_EMPTY;
+        }
+        render->listed[0][y] = render->listed[1][y] = 0;
+    }
+    render->pending_count[0] = render->pending_count[1] = 0;
+    render->scroll_count[0] = render->scroll_count[1] = 0;
+    render->dirty = 0;
+}
+
+/* Private helper that adds a cell to the ones buffer 'b' has yet to draw,
+   unless it is there already. */
+static void list_cell(render_t *render, int b, int x, int y) {
+    if (!(render->listed[b][y] & (1u << x))) {
+        render->listed[b][y] |= 1u << x;
+        render->pending[b][render->pending_count[b]++] = y*NUM_COLS + x;
+    }
+}
+
+void render_cell(render_t *render, int x, int y, int cell) {
+    if (x < 0 || x >= NUM_COLS || y < 0 || y >= NUM_ROWS || render->cells[y][x] == cell) return;
+
+    render->cells[y][x] = cell;
+    render->dirty = 1;
+    list_cell(render, 0, x, y);
+    list_cell(render, 1, x, y);
+}
+
+void render_shape(render_t *render, int x, int y, shape_t shape, int cell) {
+    const shape_info_t *info = shape_info(shape);
+
+    for (int i = 0; i < SHAPE_CELLS; i++) {
+        render_cell(render, x + info->cells[i].x, y + info->cells[i].y, cell);
+    }
+}
+
+/* Private helper that returns how many of the rows in 'cleared' are
+   below row y, which is how far a line clear moves it down. */
+static int rows_below(unsigned int cleared, int y) {
+    int count = 0;
+    unsigned int rows = y + 1 < 32 ? cleared >> (y + 1) : 0; // a tall board's bottom row is bit 31
+    for (; rows; rows &= rows - 1) {
+        count++;
+    }
+    return count;
+}
+
+void render_clear_rows(render_t *render, unsigned int cleared) {
+    int count = rows_below(cleared, -1);
+    if (count == 0) return;
+
+    // Nothing above the stack or the first cleared row moves but empty rows
+    int top = 0;
+    while (top < NUM_ROWS && !(cleared & (1u << top))) {
+        int x = 0;
+        while (x < NUM_COLS && render->cells[top][x] == RENDER_EMPTY) {
+            x++;
+        }
+        if (x < NUM_COLS) break;
+        top++;
+    }
+
+    // The cells drop like the board's rows, leaving empty ones at the top
+    int to = NUM_ROWS - 1;
+    for (int y = NUM_ROWS - 1; y >= 0; y--) {
+        if (cleared & (1u << y)) continue;
+        for (int x = 0; x < NUM_COLS; x++) {
+            render->cells[to][x] = render->cells[y][x];
+        }
+        to--;
+    }
+    for (; to >= 0; to--) {
+        for (int x = 0; x < NUM_COLS; x++) {
+            render->cells[to][x] = RENDER_EMPTY;
+        }
+    }
+
+    for (int b = 0; b < 2; b++) {
+        // Cells the buffer has yet to draw move down with their row, or go
+        // with it, and the buffer may still show something above the stack
+        int kept = 0;
+        render_scroll_t move = {cleared, top};
+        for (int i = 0; i < render->pending_count[b]; i++) {
+            int y = render->pending[b][i] / NUM_COLS;
+            if (y < move.top) move.top = y;
+            if (!(cleared & (1u << y))) {
+                render->pending[b][kept++] = render->pending[b][i] + rows_below(cleared, y)*NUM_COLS;
+            }
+        }
+        render->pending_count[b] = kept;
+        for (int y = 0; y < NUM_ROWS; y++) {
+            render->listed[b][y] = 0;
+        }
+        for (int i = 0; i < kept; i++) {
+            render->listed[b][render->pending[b][i] / NUM_COLS] |= 1u << (render->pending[b][i] % NUM_COLS);
+        }
+
+        if (render->scroll_count[b] < RENDER_MAX_SCROLLS) {
+            render->scrolls[b][render->scroll_count[b]++] = move;
+            continue;
+        }
+        render->scroll_count[b] = 0; // too far behind, draw all of it instead
+        for (int y = 0; y < NUM_ROWS; y++) {
+            for (int x = 0; x < NUM_COLS; x++) {
+                list_cell(render, b, x, y);
+            }
+        }
+    }
+    render->dirty = 1;
+}
+
+/* Private helper that moves the rows of the playfield in the draw buffer
+   from the move's top down over the cleared rows, each band of rows
+   between two cleared ones in a single move, lowest band first, and
+   fills the rows that leaves behind with the background. */
+static void scroll(render_t *render, const render_scroll_t *move) {
+    int pitch = fb_get_pitch() / sizeof(color_t);
+    int block = render->block;
+    color_t *field = (color_t *)fb_get_draw_buffer() + render->top*pitch + render->left;
+    unsigned int cleared = move->cleared;
+
+    int y = NUM_ROWS - 1;
+    while (y >= move->top) {
+        if (cleared & (1u << y)) {
+            y--;
+            continue;
+        }
+
+        int bottom = y;
+        int shift = rows_below(cleared, y)*block;
+        while (y >= move->top && !(cleared & (1u << y))) {
+            y--;
+        }
+        if (shift == 0) continue; // under the lowest cleared row
+
+        // Pixel rows from the band's last up, so none is overwritten before it moves
+        int last = (bottom + 1)*block - 1;
+        int height = (bottom - y)*block;
+        span_copy_rect(field + (last + shift)*pitch, -pitch, field + last*pitch, -pitch, NUM_COLS*block, height);
+        render->stats.scrolled += NUM_COLS*block*height;
+    }
+
+    int height = rows_below(cleared, -1)*block;
+    span_fill_rect(render->left, render->top + move->top*block, NUM_COLS*block, height, render->tiles[RENDER_EMPTY].fill);
+    render->stats.scrolled += NUM_COLS*block*height;
+}
+
+/* Private helper that draws one cell into the draw buffer: a block with
+   a one pixel black outline, or the background. */
+static void draw_cell(render_t *render, int x, int y) {
+    const tile_t *tile = &render->tiles[render->cells[y][x]];
+
+    render->stats.pixels += tile_blit(tile, render->left + x*render->block, render->top + y*render->block);
+}
+
+/* Private helper that tells which of the two buffers is the draw buffer,
+   learning their addresses as it first sees them. */
+static int back_buffer(render_t *render) {
+    void *draw = fb_get_draw_buffer();
+
+    if (render->buffers[0] == 0) render->buffers[0] = draw;
+    if (draw == render->buffers[0]) return 0;
+    if (render->buffers[1] == 0) render->buffers[1] = draw;
+    return 1;
+}
+
+int render_draw(render_t *render) {
+    int b = back_buffer(render);
+    int count = render->pending_count[b];
+
+    for (int i = 0; i < render->scroll_count[b]; i++) {
+        scroll(render, &render->scrolls[b][i]);
+    }
+    render->scroll_count[b] = 0;
+
+    for (int i = 0; i < count; i++) {
+        int cell = render->pending[b][i];
+        draw_cell(render, cell % NUM_COLS, cell / NUM_COLS);
+    }
+    for (int y = 0; y < NUM_ROWS; y++) {
+        render->listed[b][y] = 0;
+    }
+    render->pending_count[b] = 0;
+    render->stats.cells += count;
+    render->stats.frames++;
+    render->dirty = 0;
+    return count;
+}
+
+int render_frame(render_t *render) {
+    int dirty = render->dirty;
+    int count = render_draw(render);
+
+    // A buffer that was only catching up on an older frame shows nothing new
+    if (dirty) {
+        gl_swap_buffer();
+        render->stats.swaps++;
+    }
+    return count;
+}
@@ -0,0 +1,114 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "gl.h"
+#include "board.h"
+#include "shape_table.h"
+#include "tile.h"
+
+/* Module to draw the playfield a frame at a time.
+
+The game marks the cells that change while it handles a step, and
+render_frame() draws them into the back buffer and swaps once, instead
+of swapping for every block. The buffer that was on screen then lacks
+those cells, so every buffer keeps a list of the cells it has yet to
+catch up on, and it draws them the next time it is the back buffer.
+
+Cells are drawn as pre-rendered tiles, one for each shape type and one
+for the background. A line clear scrolls the pixels of the rows above
+the cleared ones down instead of drawing them again, and only draws the
+rows it uncovers at the top; a buffer that is behind does the same
+scroll before anything else the next time it is the back buffer. It
+only uses gl and fb, so it also builds on the host against the software
+framebuffer in host/softfb.
+*/
+
+#define RENDER_EMPTY 0 // cell value of an empty cell, shape type + 1 otherwise
+#define RENDER_CELLS (NUM_ROWS * NUM_COLS)
+#define RENDER_MAX_SCROLLS 4 // line clears a buffer can fall behind on before it is redrawn instead
+
+typedef struct {
+    unsigned long long frames; // calls to render_frame()
+    unsigned long long swaps;
+    unsigned long long cells; // cells drawn, in either buffer
+    unsigned long long pixels; // pixels of cells written, counting overdraw
+    unsigned long long scrolled; // pixels moved or filled by line clears
+} render_stats_t;
+
+// A line clear a buffer has yet to scroll
+typedef struct {
+    unsigned int cleared; // as in render_clear_rows()
+    int top; // rows above it are empty in the buffer and stay so
+} render_scroll_t;
+
+typedef struct {
+    int left, top, block; // screen position of the playfield and size of a cell in pixels
+    tile_t tiles[NUM_SHAPES + 1]; // what a cell looks like, by its value
+    unsigned char cells[NUM_ROWS][NUM_COLS]; // what every cell should show
+    void *buffers[2]; // address of each buffer, as fb_get_draw_buffer() gives it
+    unsigned short pending[2][RENDER_CELLS]; // cells each buffer has yet to draw, as y*NUM_COLS + x
+    int pending_count[2];
+    unsigned int listed[2][NUM_ROWS]; // the same cells as a bit per column
+    render_scroll_t scrolls[2][RENDER_MAX_SCROLLS];
+    int scroll_count[2];
+    int dirty; // whether any cell changed since the last swap
+    render_stats_t stats;
+} render_t;
+
+/* 'render_init'
+
+Sets up a renderer for a playfield at 'left', 'top' of 'block' pixel
+cells, at most TILE_MAX_SIZE, drawing shape type t in colors[t]. The
+playfield has to fit on the screen. Every cell starts empty and already
+drawn, as after clearing the screen to 'background'.
+*/
+void render_init(render_t *render, int left, int top, int block, color_t background, const color_t *colors);
+
+/* 'render_reset'
+
+Takes the board as already drawn in both buffers, e.g. after a full
+redraw of the screen, and forgets every pending cell.
+*/
+void render_reset(render_t *render, const board_t *board);
+
+/* 'render_cell'
+
+Marks the cell at x, y to show 'cell' (RENDER_EMPTY or shape type + 1)
+from the next frame on. Cells off the playfield are ignored.
+*/
+void render_cell(render_t *render, int x, int y, int cell);
+
+/* 'render_shape'
+
+Marks the cells of a shape at x, y to show 'cell', e.g. its type + 1 to
+draw it or RENDER_EMPTY to clear it.
+*/
+void render_shape(render_t *render, int x, int y, shape_t shape, int cell);
+
+/* 'render_clear_rows'
+
+Removes the rows set in 'cleared' (bit y for row y) the way the board
+does, moving the rows above them down, from the next frame on. Each
+buffer scrolls the rows from the top of the stack down in place and
+fills the strip this uncovers with the background.
+*/
+void render_clear_rows(render_t *render, unsigned int cleared);
+
+/* 'render_frame'
+
+Scrolls the back buffer for the line clears it is behind on, draws its
+pending cells and swaps the buffers, once.
+Without a cell marked since the last frame it only lets the back buffer
+catch up and does not swap. Returns the cells drawn.
+*/
+int render_frame(render_t *render);
+
+/* 'render_draw'
+
+Does what render_frame() does up to the swap, for a caller that is
+about to swap the buffers itself so the frame shows together with
+whatever else it drew. Returns the cells drawn.
+*/
+int render_draw(render_t *render);
+
+#endif
@@ -0,0 +1,163 @@
+#include "replay.h"
+
+/* Private helper that appends one byte, flushing when the buffer is full. */
+static void put_byte(replay_writer_t *writer, unsigned char byte) {
+    writer->buffer[writer->len++] = byte;
+    if (writer->len == REPLAY_BUFFER) {
+        writer->flush(writer->buffer, writer->len);
+        writer->len = 0;
+    }
+}
+
+static void put_word(replay_writer_t *writer, unsigned int word) {
+    for (int i = 0; i < 4; i++) {
+        put_byte(writer, word >> (8*i));
+    }
+}
+
+void replay_start(replay_writer_t *writer, replay_flush_fn_t flush, const engine_t *engine, unsigned int tick) {
+    writer->flush = flush;
+    writer->len = 0;
+    writer->tick = tick;
+    writer->active = 1;
+
+    put_byte(writer, 'T');
+    put_byte(writer, 'R');
+    put_byte(writer, REPLAY_VERSION);
+    put_byte(writer, engine->pieces.mode);
+    put_word(writer, engine->seed);
+    put_word(writer, engine->mostrows);
+    put_word(writer, tick);
+}
+
+void replay_record(replay_writer_t *writer, input_t input, unsigned int tick) {
+    if (!writer->active || input == INPUT_NONE) {
+        return;
+    }
+
+    unsigned int delta = tick - writer->tick;
+    writer->tick = tick;
+
+    if (delta < REPLAY_DELTA_ESCAPE) {
+        put_byte(writer, (input << 5) | delta);
+        return;
+    }
+
+    // Long pauses: escape, then the delta 7 bits at a time
+    put_byte(writer, (input << 5) | REPLAY_DELTA_ESCAPE);
+    while (delta >= 0x80) {
+        put_byte(writer, (delta & 0x7F) | 0x80);
+        delta >>= 7;
+    }
+    put_byte(writer, delta);
+}
+
+void replay_finish(replay_writer_t *writer, const engine_t *engine) {
+    if (!writer->active) {
+        return;
+    }
+
+    snapshot_t final;
+    snapshot_take(engine, &final);
+
+    put_byte(writer, INPUT_NONE << 5);
+    for (int i = 0; i < SNAPSHOT_SIZE; i++) {
+        put_byte(writer, final.bytes[i]);
+    }
+
+    if (writer->len > 0) {
+        writer->flush(writer->buffer, writer->len);
+        writer->len = 0;
+    }
+    writer->active = 0;
+}
+
+void replay_abort(replay_writer_t *writer) {
+    if (!writer->active) {
+        return;
+    }
+
+    put_byte(writer, REPLAY_ABORT);
+    if (writer->len > 0) {
+        writer->flush(writer->buffer, writer->len);
+        writer->len = 0;
+    }
+    writer->active = 0;
+}
+
+static unsigned int get_word(const unsigned char *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+/* Private helper that returns whether a log header starts at 'p'. */
+static int is_header(const unsigned char *p, const unsigned char *end) {
+    return end - p >= 3 && p[0] == 'T' && p[1] == 'R' && p[2] == REPLAY_VERSION;
+}
+
+replay_status_t replay_open(replay_reader_t *reader, const unsigned char *bytes, int len) {
+    if (len < REPLAY_HEADER_SIZE || bytes[0] != 'T' || bytes[1] != 'R' || bytes[2] != REPLAY_VERSION) {
+        return REPLAY_ERROR;
+    }
+
+    reader->mode = bytes[3] ? PIECES_BAG : PIECES_RANDOM;
+    reader->seed = get_word(bytes + 4);
+    reader->mostrows = get_word(bytes + 8);
+    reader->tick = get_word(bytes + 12);
+    reader->start = bytes;
+    reader->p = bytes + REPLAY_HEADER_SIZE;
+    reader->end = bytes + len;
+
+    return REPLAY_INPUT;
+}
+
+replay_status_t replay_read(replay_reader_t *reader, input_t *input, unsigned int *tick, snapshot_t *final) {
+    if (reader->p >= reader->end || is_header(reader->p, reader->end)) {
+        return REPLAY_ERROR;
+    }
+
+    unsigned char record = *reader->p++;
+    *input = (input_t)(record >> 5);
+
+    if (record == REPLAY_ABORT) {
+        return REPLAY_ABORTED;
+    }
+    if (*input == INPUT_NONE) {
+        if (record != INPUT_NONE << 5 || reader->end - reader->p < SNAPSHOT_SIZE) {
+            return REPLAY_ERROR;
+        }
+        for (int i = 0; i < SNAPSHOT_SIZE; i++) {
+            final->bytes[i] = *reader->p++;
+        }
+        return REPLAY_END;
+    }
+
+    if (*input > INPUT_GRAVITY) {
+        return REPLAY_ERROR;
+    }
+
+    unsigned int delta = record & 0x1F;
+    if (delta == REPLAY_DELTA_ESCAPE) {
+        delta = 0;
+        for (int shift = 0; ; shift += 7) {
+            if (reader->p >= reader->end || shift > 28) {
+                return REPLAY_ERROR;
+            }
+            unsigned char byte = *reader->p++;
+            delta |= (unsigned int)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+    }
+
+    reader->tick += delta;
+    *tick = reader->tick;
+    return REPLAY_INPUT;
+}
+
+int replay_resync(replay_reader_t *reader) {
+    const unsigned char *p = reader->start + 1;
+    while (p < reader->end && !is_header(p, reader->end)) {
+        p++;
+    }
+    reader->p = p;
+    return p < reader->end;
+}
@@ -0,0 +1,115 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "engine.h"
+#include "snapshot.h"
+
+/* Module for compact input logs of whole games.
+
+A log starts with a header holding the seed and piece mode of the game,
+followed by one record per input the engine was fed (key presses, glove
+moves and gravity ticks alike) and ends with a snapshot of the final
+state, or with an abort record if the game was left before it ended. Since the engine is deterministic, feeding the same inputs to a
+game started from the same seed must reproduce that final state, which
+is how the host replay tool detects desyncs.
+
+Layout, all multi-byte values little-endian:
+  header: 'T' 'R' version mode seed[4] mostrows[4] tick[4]
+  record: (input << 5) | delta, with delta in 0-30 ticks since the last
+          record; delta 31 is followed by the real delta as a varint
+  end:    0x00 followed by a SNAPSHOT_SIZE byte snapshot
+  abort:  0xE0, an input no log has
+A header can never be read as records (its third byte would be an end
+record with a delta), so a reader that runs into one knows the log
+before it was cut off.
+
+The writer collects bytes in a small buffer and hands them to a flush
+function whenever it fills up, so a log can be streamed out over the
+UART while the game is running.
+*/
+
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 16
+#define REPLAY_BUFFER 32
+#define REPLAY_DELTA_ESCAPE 31
+#define REPLAY_ABORT 0xE0
+
+// Receives the bytes of a log as they are written
+typedef void (*replay_flush_fn_t)(const unsigned char *bytes, int len);
+
+typedef struct {
+    unsigned char buffer[REPLAY_BUFFER];
+    int len;
+    unsigned int tick; // tick of the last record
+    int active; // 1 between replay_start() and replay_finish()
+    replay_flush_fn_t flush;
+} replay_writer_t;
+
+typedef struct {
+    const unsigned char *start; // header of the log being read
+    const unsigned char *p;
+    const unsigned char *end;
+    unsigned int tick;
+    unsigned int seed;
+    unsigned int mostrows;
+    piece_mode_t mode;
+} replay_reader_t;
+
+typedef enum {
+    REPLAY_INPUT = 0, // an input was read
+    REPLAY_END, // the final snapshot was read
+    REPLAY_ABORTED, // the game was left before it ended
+    REPLAY_ERROR, // the log is cut short or malformed
+} replay_status_t;
+
+/* 'replay_start'
+
+Starts logging the game the engine just began, at timer tick 'tick'.
+*/
+void replay_start(replay_writer_t *writer, replay_flush_fn_t flush, const engine_t *engine, unsigned int tick);
+
+/* 'replay_record'
+
+Logs one input fed to the engine at timer tick 'tick'. Does nothing if
+no log is active.
+*/
+void replay_record(replay_writer_t *writer, input_t input, unsigned int tick);
+
+/* 'replay_finish'
+
+Ends the log with a snapshot of the final state and flushes it.
+*/
+void replay_finish(replay_writer_t *writer, const engine_t *engine);
+
+/* 'replay_abort'
+
+Ends the log of a game that is being left before it is over, such as a
+demo interrupted by a key press. Does nothing if no log is active.
+*/
+void replay_abort(replay_writer_t *writer);
+
+/* 'replay_open'
+
+Reads the header of the log in bytes[0..len). Returns REPLAY_INPUT if
+records follow, REPLAY_ERROR if it is not a log of this version.
+*/
+replay_status_t replay_open(replay_reader_t *reader, const unsigned char *bytes, int len);
+
+/* 'replay_read'
+
+Reads the next record. On REPLAY_INPUT, 'input' and 'tick' are set; on
+REPLAY_END, 'final' holds the snapshot that ends the log. It returns
+REPLAY_ERROR, without reading on, when the next log's header comes
+before this one ended.
+*/
+replay_status_t replay_read(replay_reader_t *reader, input_t *input, unsigned int *tick, snapshot_t *final);
+
+/* 'replay_resync'
+
+Moves 'reader' to the header of the first log after the start of the one
+it was reading, for going on after a log that REPLAY_ERROR cut short.
+Returns 0 if there is none.
+*/
+int replay_resync(replay_reader_t *reader);
+
+#endif
@@ -0,0 +1,89 @@
+#include "rng.h"
+
+static unsigned int rotl(unsigned int x, int k) {
+    return (x << k) | (x >> (32 - k));
+}
+
+/* Private helper that scrambles the seed into well-mixed state words
+   (splitmix32), so similar seeds still give unrelated sequences. */
+static unsigned int splitmix(unsigned int *x) {
+    unsigned int z = (*x += 0x9E3779B9);
+    z = (z ^ (z >> 16)) * 0x85EBCA6B;
+    z = (z ^ (z >> 13)) * 0xC2B2AE35;
+    return z ^ (z >> 16);
+}
+
+void rng_seed(rng_t *rng, unsigned int seed) {
+    for (int i = 0; i < 4; i++) {
+        rng->s[i] = splitmix(&seed);
+    }
+
+    if ((rng->s[0] | rng->s[1] | rng->s[2] | rng->s[3]) == 0) { // the one state xoshiro cannot leave
+        rng->s[0] = 1;
+    }
+}
+
+unsigned int rng_next(rng_t *rng) {
+    unsigned int *s = rng->s;
+    unsigned int result = rotl(s[1] * 5, 7) * 9;
+    unsigned int t = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 11);
+
+    return result;
+}
+
+unsigned int rng_below(rng_t *rng, unsigned int n) {
+    // Scales the 32 random bits into [0, n) with one multiply instead of a division
+    return (unsigned int)(((unsigned long long)rng_next(rng) * n) >> 32);
+}
+
+/* Private helper that produces the next shape type of the sequence. */
+static int draw_piece(pieces_t *pieces) {
+    if (pieces->mode == PIECES_RANDOM) {
+        return rng_below(&pieces->rng, 7);
+    }
+
+    if (pieces->bag_left == 0) { // refill the bag with all seven shapes
+        for (int i = 0; i < 7; i++) {
+            pieces->bag[i] = i;
+        }
+        pieces->bag_left = 7;
+    }
+
+    // Take a random shape out of the bag and move the last one into its place
+    unsigned int pick = rng_below(&pieces->rng, pieces->bag_left);
+    int type = pieces->bag[pick];
+    pieces->bag[pick] = pieces->bag[--pieces->bag_left];
+
+    return type;
+}
+
+void pieces_init(pieces_t *pieces, unsigned int seed, piece_mode_t mode) {
+    rng_seed(&pieces->rng, seed);
+    pieces->mode = mode;
+    pieces->bag_left = 0;
+    pieces->head = 0;
+
+    for (int i = 0; i < PIECE_PREVIEW; i++) {
+        pieces->queue[i] = draw_piece(pieces);
+    }
+}
+
+int pieces_next(pieces_t *pieces) {
+    int type = pieces->queue[pieces->head];
+
+    pieces->queue[pieces->head] = draw_piece(pieces);
+    pieces->head = (pieces->head + 1) % PIECE_PREVIEW;
+
+    return type;
+}
+
+int pieces_peek(const pieces_t *pieces, int ahead) {
+    return pieces->queue[(pieces->head + ahead) % PIECE_PREVIEW];
+}
@@ -0,0 +1,75 @@
+#ifndef RNG_H
+#define RNG_H
+
+/* Module for deterministic random numbers and shape sequences.
+
+rng_t is a small xoshiro128** generator whose whole state is four words,
+so a game started from the same seed always sees the same shapes, and a
+generator can be copied, saved and restored like any other value.
+
+pieces_t turns it into the sequence of shape types a game plays with,
+either uniformly at random (like the original randomizer) or from a
+shuffled bag of all seven shapes, and keeps the next PIECE_PREVIEW
+shapes queued so they can be previewed before they are played. Nothing
+here allocates memory.
+*/
+
+#define PIECE_PREVIEW 6 // shapes visible in the lookahead queue
+
+typedef struct {
+    unsigned int s[4];
+} rng_t;
+
+typedef enum {
+    PIECES_RANDOM = 0, // every shape uniformly at random
+    PIECES_BAG, // all seven shapes in random order, then the next seven
+} piece_mode_t;
+
+typedef struct {
+    rng_t rng;
+    piece_mode_t mode;
+    unsigned char bag[7]; // shapes left in the current bag are bag[0..bag_left)
+    unsigned char bag_left;
+    unsigned char queue[PIECE_PREVIEW]; // ring of upcoming shapes, oldest at 'head'
+    unsigned char head;
+} pieces_t;
+
+/* 'rng_seed'
+
+Starts the generator from a 32-bit seed. Every seed, 0 included, gives
+a usable generator.
+*/
+void rng_seed(rng_t *rng, unsigned int seed);
+
+/* 'rng_next'
+
+Returns the next 32 random bits.
+*/
+unsigned int rng_next(rng_t *rng);
+
+/* 'rng_below'
+
+Returns a random number from 0 to n - 1.
+*/
+unsigned int rng_below(rng_t *rng, unsigned int n);
+
+/* 'pieces_init'
+
+Starts a shape sequence from 'seed' and fills the lookahead queue.
+*/
+void pieces_init(pieces_t *pieces, unsigned int seed, piece_mode_t mode);
+
+/* 'pieces_next'
+
+Takes the oldest shape type (0-6) off the queue and queues a new one.
+*/
+int pieces_next(pieces_t *pieces);
+
+/* 'pieces_peek'
+
+Returns the shape type 'ahead' places from the front of the queue,
+without taking it. 'ahead' must be less than PIECE_PREVIEW.
+*/
+int pieces_peek(const pieces_t *pieces, int ahead);
+
+#endif
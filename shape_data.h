@@ -0,0 +1,196 @@
+#ifndef SHAPE_DATA_H
+#define SHAPE_DATA_H
+
+/* The 4x4 maps of every shape in every orientation. This is the source
+data for the precompiled SHAPE_INFO table: host/gen_shape_table.c reads
+it and writes shape_table.c, so nothing on the Pi includes this file.
+Orientations are listed clockwise.
+*/
+
+static const char SHAPE[7][4][4][4] = // 7 shapes, 4 orientations each, 4 y cordinates, 4 x cordinates 
+{
+    { // I-shape
+        {
+            {0, 0, 0, 0}, 
+            {1, 1, 1, 1}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 0, 1, 0}, 
+            {0, 0, 1, 0}, 
+            {0, 0, 1, 0}, 
+            {0, 0, 1, 0}
+        },
+        {
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}, 
+            {1, 1, 1, 1}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 0, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 1, 0, 0}
+        }
+    },
+    { // J-shape
+        {
+            {1, 0, 0, 0}, 
+            {1, 1, 1, 0}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 1, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 0, 0, 0}, 
+            {1, 1, 1, 0}, 
+            {0, 0, 1, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 0, 0}, 
+            {0, 1, 0, 0}, 
+            {1, 1, 0, 0}, 
+            {0, 0, 0, 0}
+        }
+    },
+    { // L-shape
+        {
+            {0, 0, 1, 0}, 
+            {1, 1, 1, 0}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 0, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 0, 0, 0}, 
+            {1, 1, 1, 0}, 
+            {1, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {1, 1, 0, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 0, 0, 0}
+        }
+    },
+    { // O-shape
+        {
+            {0, 1, 1, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 1, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 1, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 1, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        }
+    },
+    { // S-shape
+        {
+            {0, 1, 1, 0}, 
+            {1, 1, 0, 0}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 0, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 0, 1, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 0, 0, 0}, 
+            {0, 1, 1, 0}, 
+            {1, 1, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {1, 0, 0, 0}, 
+            {1, 1, 0, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 0, 0, 0}
+        }
+    },
+    { // T-shape
+        {
+            {0, 1, 0, 0}, 
+            {1, 1, 1, 0}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 0, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 0, 0, 0}, 
+            {1, 1, 1, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 0, 0}, 
+            {1, 1, 0, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 0, 0, 0}
+        }
+    },
+    { // Z-shape
+        {
+            {1, 1, 0, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 0, 1, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 1, 0, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 0, 0, 0}, 
+            {1, 1, 0, 0}, 
+            {0, 1, 1, 0}, 
+            {0, 0, 0, 0}
+        },
+        {
+            {0, 1, 0, 0}, 
+            {1, 1, 0, 0}, 
+            {1, 0, 0, 0}, 
+            {0, 0, 0, 0}
+        }
+    }
+};
+
+#endif
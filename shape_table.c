@@ -0,0 +1,244 @@
+/* Generated by host/gen_shape_table.c from shape_data.h. Do not edit. */
+
+#include "shape_table.h"
+
+const shape_info_t SHAPE_INFO[NUM_SHAPES][NUM_ORIENTATIONS] = {
+  {
+    { // I-shape, orientation 0
+        .cells = {{0, 1}, {1, 1}, {2, 1}, {3, 1}},
+        .masks = {0x0, 0xf, 0x0, 0x0},
+        .left = 0, .right = 3, .top = 1, .bottom = 1,
+        .bottom_profile = {1, 1, 1, 1},
+        .left_profile = {-1, 0, -1, -1},
+        .right_profile = {-1, 3, -1, -1},
+    },
+    { // I-shape, orientation 1
+        .cells = {{2, 0}, {2, 1}, {2, 2}, {2, 3}},
+        .masks = {0x4, 0x4, 0x4, 0x4},
+        .left = 2, .right = 2, .top = 0, .bottom = 3,
+        .bottom_profile = {-1, -1, 3, -1},
+        .left_profile = {2, 2, 2, 2},
+        .right_profile = {2, 2, 2, 2},
+    },
+    { // I-shape, orientation 2
+        .cells = {{0, 2}, {1, 2}, {2, 2}, {3, 2}},
+        .masks = {0x0, 0x0, 0xf, 0x0},
+        .left = 0, .right = 3, .top = 2, .bottom = 2,
+        .bottom_profile = {2, 2, 2, 2},
+        .left_profile = {-1, -1, 0, -1},
+        .right_profile = {-1, -1, 3, -1},
+    },
+    { // I-shape, orientation 3
+        .cells = {{1, 0}, {1, 1}, {1, 2}, {1, 3}},
+        .masks = {0x2, 0x2, 0x2, 0x2},
+        .left = 1, .right = 1, .top = 0, .bottom = 3,
+        .bottom_profile = {-1, 3, -1, -1},
+        .left_profile = {1, 1, 1, 1},
+        .right_profile = {1, 1, 1, 1},
+    },
+  },
+  {
+    { // J-shape, orientation 0
+        .cells = {{0, 0}, {0, 1}, {1, 1}, {2, 1}},
+        .masks = {0x1, 0x7, 0x0, 0x0},
+        .left = 0, .right = 2, .top = 0, .bottom = 1,
+        .bottom_profile = {1, 1, 1, -1},
+        .left_profile = {0, 0, -1, -1},
+        .right_profile = {0, 2, -1, -1},
+    },
+    { // J-shape, orientation 1
+        .cells = {{1, 0}, {2, 0}, {1, 1}, {1, 2}},
+        .masks = {0x6, 0x2, 0x2, 0x0},
+        .left = 1, .right = 2, .top = 0, .bottom = 2,
+        .bottom_profile = {-1, 2, 0, -1},
+        .left_profile = {1, 1, 1, -1},
+        .right_profile = {2, 1, 1, -1},
+    },
+    { // J-shape, orientation 2
+        .cells = {{0, 1}, {1, 1}, {2, 1}, {2, 2}},
+        .masks = {0x0, 0x7, 0x4, 0x0},
+        .left = 0, .right = 2, .top = 1, .bottom = 2,
+        .bottom_profile = {1, 1, 2, -1},
+        .left_profile = {-1, 0, 2, -1},
+        .right_profile = {-1, 2, 2, -1},
+    },
+    { // J-shape, orientation 3
+        .cells = {{1, 0}, {1, 1}, {0, 2}, {1, 2}},
+        .masks = {0x2, 0x2, 0x3, 0x0},
+        .left = 0, .right = 1, .top = 0, .bottom = 2,
+        .bottom_profile = {2, 2, -1, -1},
+        .left_profile = {1, 1, 0, -1},
+        .right_profile = {1, 1, 1, -1},
+    },
+  },
+  {
+    { // L-shape, orientation 0
+        .cells = {{2, 0}, {0, 1}, {1, 1}, {2, 1}},
+        .masks = {0x4, 0x7, 0x0, 0x0},
+        .left = 0, .right = 2, .top = 0, .bottom = 1,
+        .bottom_profile = {1, 1, 1, -1},
+        .left_profile = {2, 0, -1, -1},
+        .right_profile = {2, 2, -1, -1},
+    },
+    { // L-shape, orientation 1
+        .cells = {{1, 0}, {1, 1}, {1, 2}, {2, 2}},
+        .masks = {0x2, 0x2, 0x6, 0x0},
+        .left = 1, .right = 2, .top = 0, .bottom = 2,
+        .bottom_profile = {-1, 2, 2, -1},
+        .left_profile = {1, 1, 1, -1},
+        .right_profile = {1, 1, 2, -1},
+    },
+    { // L-shape, orientation 2
+        .cells = {{0, 1}, {1, 1}, {2, 1}, {0, 2}},
+        .masks = {0x0, 0x7, 0x1, 0x0},
+        .left = 0, .right = 2, .top = 1, .bottom = 2,
+        .bottom_profile = {2, 1, 1, -1},
+        .left_profile = {-1, 0, 0, -1},
+        .right_profile = {-1, 2, 0, -1},
+    },
+    { // L-shape, orientation 3
+        .cells = {{0, 0}, {1, 0}, {1, 1}, {1, 2}},
+        .masks = {0x3, 0x2, 0x2, 0x0},
+        .left = 0, .right = 1, .top = 0, .bottom = 2,
+        .bottom_profile = {0, 2, -1, -1},
+        .left_profile = {0, 1, 1, -1},
+        .right_profile = {1, 1, 1, -1},
+    },
+  },
+  {
+    { // O-shape, orientation 0
+        .cells = {{1, 0}, {2, 0}, {1, 1}, {2, 1}},
+        .masks = {0x6, 0x6, 0x0, 0x0},
+        .left = 1, .right = 2, .top = 0, .bottom = 1,
+        .bottom_profile = {-1, 1, 1, -1},
+        .left_profile = {1, 1, -1, -1},
+        .right_profile = {2, 2, -1, -1},
+    },
+    { // O-shape, orientation 1
+        .cells = {{1, 0}, {2, 0}, {1, 1}, {2, 1}},
+        .masks = {0x6, 0x6, 0x0, 0x0},
+        .left = 1, .right = 2, .top = 0, .bottom = 1,
+        .bottom_profile = {-1, 1, 1, -1},
+        .left_profile = {1, 1, -1, -1},
+        .right_profile = {2, 2, -1, -1},
+    },
+    { // O-shape, orientation 2
+        .cells = {{1, 0}, {2, 0}, {1, 1}, {2, 1}},
+        .masks = {0x6, 0x6, 0x0, 0x0},
+        .left = 1, .right = 2, .top = 0, .bottom = 1,
+        .bottom_profile = {-1, 1, 1, -1},
+        .left_profile = {1, 1, -1, -1},
+        .right_profile = {2, 2, -1, -1},
+    },
+    { // O-shape, orientation 3
+        .cells = {{1, 0}, {2, 0}, {1, 1}, {2, 1}},
+        .masks = {0x6, 0x6, 0x0, 0x0},
+        .left = 1, .right = 2, .top = 0, .bottom = 1,
+        .bottom_profile = {-1, 1, 1, -1},
+        .left_profile = {1, 1, -1, -1},
+        .right_profile = {2, 2, -1, -1},
+    },
+  },
+  {
+    { // S-shape, orientation 0
+        .cells = {{1, 0}, {2, 0}, {0, 1}, {1, 1}},
+        .masks = {0x6, 0x3, 0x0, 0x0},
+        .left = 0, .right = 2, .top = 0, .bottom = 1,
+        .bottom_profile = {1, 1, 0, -1},
+        .left_profile = {1, 0, -1, -1},
+        .right_profile = {2, 1, -1, -1},
+    },
+    { // S-shape, orientation 1
+        .cells = {{1, 0}, {1, 1}, {2, 1}, {2, 2}},
+        .masks = {0x2, 0x6, 0x4, 0x0},
+        .left = 1, .right = 2, .top = 0, .bottom = 2,
+        .bottom_profile = {-1, 1, 2, -1},
+        .left_profile = {1, 1, 2, -1},
+        .right_profile = {1, 2, 2, -1},
+    },
+    { // S-shape, orientation 2
+        .cells = {{1, 1}, {2, 1}, {0, 2}, {1, 2}},
+        .masks = {0x0, 0x6, 0x3, 0x0},
+        .left = 0, .right = 2, .top = 1, .bottom = 2,
+        .bottom_profile = {2, 2, 1, -1},
+        .left_profile = {-1, 1, 0, -1},
+        .right_profile = {-1, 2, 1, -1},
+    },
+    { // S-shape, orientation 3
+        .cells = {{0, 0}, {0, 1}, {1, 1}, {1, 2}},
+        .masks = {0x1, 0x3, 0x2, 0x0},
+        .left = 0, .right = 1, .top = 0, .bottom = 2,
+        .bottom_profile = {1, 2, -1, -1},
+        .left_profile = {0, 0, 1, -1},
+        .right_profile = {0, 1, 1, -1},
+    },
+  },
+  {
+    { // T-shape, orientation 0
+        .cells = {{1, 0}, {0, 1}, {1, 1}, {2, 1}},
+        .masks = {0x2, 0x7, 0x0, 0x0},
+        .left = 0, .right = 2, .top = 0, .bottom = 1,
+        .bottom_profile = {1, 1, 1, -1},
+        .left_profile = {1, 0, -1, -1},
+        .right_profile = {1, 2, -1, -1},
+    },
+    { // T-shape, orientation 1
+        .cells = {{1, 0}, {1, 1}, {2, 1}, {1, 2}},
+        .masks = {0x2, 0x6, 0x2, 0x0},
+        .left = 1, .right = 2, .top = 0, .bottom = 2,
+        .bottom_profile = {-1, 2, 1, -1},
+        .left_profile = {1, 1, 1, -1},
+        .right_profile = {1, 2, 1, -1},
+    },
+    { // T-shape, orientation 2
+        .cells = {{0, 1}, {1, 1}, {2, 1}, {1, 2}},
+        .masks = {0x0, 0x7, 0x2, 0x0},
+        .left = 0, .right = 2, .top = 1, .bottom = 2,
+        .bottom_profile = {1, 2, 1, -1},
+        .left_profile = {-1, 0, 1, -1},
+        .right_profile = {-1, 2, 1, -1},
+    },
+    { // T-shape, orientation 3
+        .cells = {{1, 0}, {0, 1}, {1, 1}, {1, 2}},
+        .masks = {0x2, 0x3, 0x2, 0x0},
+        .left = 0, .right = 1, .top = 0, .bottom = 2,
+        .bottom_profile = {1, 2, -1, -1},
+        .left_profile = {1, 0, 1, -1},
+        .right_profile = {1, 1, 1, -1},
+    },
+  },
+  {
+    { // Z-shape, orientation 0
+        .cells = {{0, 0}, {1, 0}, {1, 1}, {2, 1}},
+        .masks = {0x3, 0x6, 0x0, 0x0},
+        .left = 0, .right = 2, .top = 0, .bottom = 1,
+        .bottom_profile = {0, 1, 1, -1},
+        .left_profile = {0, 1, -1, -1},
+        .right_profile = {1, 2, -1, -1},
+    },
+    { // Z-shape, orientation 1
+        .cells = {{2, 0}, {1, 1}, {2, 1}, {1, 2}},
+        .masks = {0x4, 0x6, 0x2, 0x0},
+        .left = 1, .right = 2, .top = 0, .bottom = 2,
+        .bottom_profile = {-1, 2, 1, -1},
+        .left_profile = {2, 1, 1, -1},
+        .right_profile = {2, 2, 1, -1},
+    },
+    { // Z-shape, orientation 2
+        .cells = {{0, 1}, {1, 1}, {1, 2}, {2, 2}},
+        .masks = {0x0, 0x3, 0x6, 0x0},
+        .left = 0, .right = 2, .top = 1, .bottom = 2,
+        .bottom_profile = {1, 2, 2, -1},
+        .left_profile = {-1, 0, 1, -1},
+        .right_profile = {-1, 1, 2, -1},
+    },
+    { // Z-shape, orientation 3
+        .cells = {{1, 0}, {0, 1}, {1, 1}, {0, 2}},
+        .masks = {0x2, 0x3, 0x1, 0x0},
+        .left = 0, .right = 1, .top = 0, .bottom = 2,
+        .bottom_profile = {2, 1, -1, -1},
+        .left_profile = {1, 0, 0, -1},
+        .right_profile = {1, 1, 0, -1},
+    },
+  },
+};
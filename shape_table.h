@@ -0,0 +1,48 @@
+#ifndef SHAPE_TABLE_H
+#define SHAPE_TABLE_H
+
+/* Module for the precompiled shape table.
+
+SHAPE_INFO holds, for each of the 7 shapes in each of its 4 orientations,
+everything the game needs to know about its 4x4 map: row masks for the
+bitboard, the positions of its four filled cells, its bounding box and
+its bottom/left/right profiles. All offsets are inside the 4x4 map, so
+a shape at (x, y) fills cell (x + mapX, y + mapY).
+
+The table in shape_table.c is generated by host/gen_shape_table.c from
+the SHAPE maps in shape_data.h. Edit shape_data.h and run
+"make -C host table" instead of editing shape_table.c by hand.
+*/
+
+#define NUM_SHAPES 7
+#define NUM_ORIENTATIONS 4
+#define SHAPE_CELLS 4
+
+// A shape in play is only its type and orientation, everything else is in SHAPE_INFO
+typedef struct {
+    int type; // 0-6, indicating which shape it is
+    int orientation; // 0-3, indicating which orientation it is
+} shape_t;
+
+typedef struct {
+    unsigned char masks[4]; // bit mapX of masks[mapY] is set when the map is filled there
+    struct {
+        signed char x, y;
+    } cells[SHAPE_CELLS]; // filled cells, top to bottom and left to right
+    signed char left, right, top, bottom; // bounding box of the filled cells, inclusive
+    signed char bottom_profile[4]; // per map column, lowest filled mapY or -1 if empty
+    signed char left_profile[4]; // per map row, leftmost filled mapX or -1 if empty
+    signed char right_profile[4]; // per map row, rightmost filled mapX or -1 if empty
+} shape_info_t;
+
+extern const shape_info_t SHAPE_INFO[NUM_SHAPES][NUM_ORIENTATIONS];
+
+/* 'shape_info'
+
+Returns the precompiled table entry for the shape's type and orientation.
+*/
+static inline const shape_info_t *shape_info(shape_t shape) {
+    return &SHAPE_INFO[shape.type][shape.orientation];
+}
+
+#endif
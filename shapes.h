@@ -2,6 +2,8 @@
 #define SHAPES_H
 
 #include "gl.h"
+#include "board.h"
+#include "shape_table.h"
 
 /* Module to define shapes and their properties. 
 
@@ -14,19 +16,8 @@ Last Update: 12/7/2022
 
 */
 
-// struct for shapes, which are 2x4 arrays of 1s and 0s
-typedef struct {
-    color_t color; // color of shape
-    char map[4][4]; // 4x4 array of 1s and 0s
-    int type; // 0-6, indicating which shape it is
-    int orientation; // 0-3, indicating which orientation it is
-} shape_t;
-
-/* 'random_start_shape'
-
-Generates a random shape in the starting orientation.
-*/
-shape_t random_start_shape(void);
+/* Color of each shape type, as get_color() gives it. */
+extern color_t COLOR[NUM_SHAPES];
 
 /* 'get_shape'
 
@@ -40,30 +31,18 @@ Draws a shape using raw x and y cords.
 */
 void draw_shape_raw(int x, int y, shape_t shape, unsigned int blocksize);
 
-/* 'draw_shape'
-
-Draws a shape.
-*/
-void draw_shape(int x, int y, shape_t shape);
-
-/* 'clear_shape'
-
-Draws a shape.
-*/
-void clear_shape(int x, int y, shape_t shape);
-
 /* 'place_shape'
 
-Places a shape into the placedblock array.
+Places a shape into the placedblocks board.
 */
-void place_shape(int x, int y, shape_t shape, char** placedblocks, unsigned int NUM_ROWS, unsigned int NUM_COLS);
+void place_shape(int x, int y, shape_t shape, board_t *placedblocks);
 
 /* 'valid_shape_position'
 
 Returns 1 if a shape is in a valid position (filled parts of the shape are
 in bounds and not on placed blocks). Returns 0 if not.
 */
-unsigned int valid_shape_position(int x, int y, shape_t shape, char** placedblocks, unsigned int NUM_ROWS, unsigned int NUM_COLS);
+unsigned int valid_shape_position(int x, int y, shape_t shape, const board_t *placedblocks);
 
 /* 'get_color
 
@@ -0,0 +1,133 @@
+#include "snapshot.h"
+
+static unsigned char *put_word(unsigned char *p, unsigned int word) {
+    p[0] = word;
+    p[1] = word >> 8;
+    p[2] = word >> 16;
+    p[3] = word >> 24;
+    return p + 4;
+}
+
+static const unsigned char *get_word(const unsigned char *p, unsigned int *word) {
+    *word = p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+    return p + 4;
+}
+
+static unsigned char *put_row(unsigned char *p, unsigned long long row) {
+    for (int i = 0; i < SNAPSHOT_ROW_BYTES; i++) {
+        p[i] = row >> (8*i);
+    }
+    return p + SNAPSHOT_ROW_BYTES;
+}
+
+static const unsigned char *get_row(const unsigned char *p, unsigned long long *row) {
+    *row = 0;
+    for (int i = 0; i < SNAPSHOT_ROW_BYTES; i++) {
+        *row |= (unsigned long long)p[i] << (8*i);
+    }
+    return p + SNAPSHOT_ROW_BYTES;
+}
+
+void snapshot_take(const engine_t *engine, snapshot_t *snapshot) {
+    unsigned char *p = snapshot->bytes;
+    const pieces_t *pieces = &engine->pieces;
+
+    *p++ = SNAPSHOT_VERSION;
+
+    // 3 bits per cell holding the shape type + 1
+    for (int y = 0; y < NUM_ROWS; y++) {
+        const char *colors = engine->board.colors[engine->board.slot[y]];
+        unsigned long long row = 0;
+        for (int x = 0; x < NUM_COLS; x++) {
+            row |= (unsigned long long)colors[x] << (3*x);
+        }
+        p = put_row(p, row);
+    }
+
+    *p++ = engine->curr.shape.type | (engine->curr.shape.orientation << 3) |
+           (engine->curr.visible << 5) | (engine->over << 6) | (pieces->mode << 7);
+    *p++ = (signed char)engine->curr.x;
+    *p++ = (signed char)engine->curr.y;
+    *p++ = engine->next.type | (engine->next.orientation << 3);
+
+    p = put_word(p, engine->rowscleared);
+    p = put_word(p, engine->mostrows);
+    p = put_word(p, engine->seed);
+
+    for (int i = 0; i < 4; i++) {
+        p = put_word(p, pieces->rng.s[i]);
+    }
+
+    unsigned int bag = (unsigned int)pieces->bag_left << 28;
+    for (int i = 0; i < 7; i++) {
+        bag |= (unsigned int)pieces->bag[i] << (4*i);
+    }
+    p = put_word(p, bag);
+
+    // The lookahead queue from its front, two shapes per byte
+    for (int i = 0; i < PIECE_PREVIEW; i += 2) {
+        unsigned char pair = pieces_peek(pieces, i);
+        if (i + 1 < PIECE_PREVIEW) pair |= pieces_peek(pieces, i + 1) << 4;
+        *p++ = pair;
+    }
+}
+
+unsigned int snapshot_restore(engine_t *engine, const snapshot_t *snapshot) {
+    const unsigned char *p = snapshot->bytes;
+    pieces_t *pieces = &engine->pieces;
+    unsigned int word;
+    unsigned long long row;
+
+    if (*p++ != SNAPSHOT_VERSION) {
+        return 0;
+    }
+
+    board_init(&engine->board);
+    for (int y = 0; y < NUM_ROWS; y++) {
+        p = get_row(p, &row);
+        for (int x = 0; x < NUM_COLS; x++) {
+            char cell = (row >> (3*x)) & 7;
+            if (cell) {
+                engine->board.rows[y] |= 1 << (x + BOARD_WALL);
+                engine->board.colors[engine->board.slot[y]][x] = cell;
+            }
+        }
+    }
+    board_rebuild(&engine->board);
+
+    unsigned char flags = *p++;
+    engine->curr.shape.type = flags & 7;
+    engine->curr.shape.orientation = (flags >> 3) & 3;
+    engine->curr.visible = (flags >> 5) & 1;
+    engine->over = (flags >> 6) & 1;
+    pieces->mode = (flags >> 7) ? PIECES_BAG : PIECES_RANDOM;
+    engine->curr.x = (signed char)*p++;
+    engine->curr.y = (signed char)*p++;
+    engine->next.type = *p & 7;
+    engine->next.orientation = (*p++ >> 3) & 3;
+
+    p = get_word(p, &engine->rowscleared);
+    p = get_word(p, &engine->mostrows);
+    p = get_word(p, &engine->seed);
+    engine->startingX = (NUM_COLS / 2) - 2;
+    engine->spawned = 0; // not saved, only counts shapes since the restore
+
+    for (int i = 0; i < 4; i++) {
+        p = get_word(p, &pieces->rng.s[i]);
+    }
+
+    p = get_word(p, &word);
+    pieces->bag_left = word >> 28;
+    for (int i = 0; i < 7; i++) {
+        pieces->bag[i] = (word >> (4*i)) & 0xF;
+    }
+
+    pieces->head = 0;
+    for (int i = 0; i < PIECE_PREVIEW; i += 2) {
+        pieces->queue[i] = *p & 0xF;
+        if (i + 1 < PIECE_PREVIEW) pieces->queue[i + 1] = *p >> 4;
+        p++;
+    }
+
+    return 1;
+}
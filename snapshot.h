@@ -0,0 +1,44 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "engine.h"
+
+/* Module to save the complete state of a game into a small fixed-size
+blob and restore it later: the board, the shape in play with its
+position, the next shape, the scores and the state of the shape
+generator. Restoring a snapshot and taking it again gives back the
+same bytes, and a restored game plays on exactly like the original.
+
+The layout is explicit little-endian bytes, independent of struct
+padding, so snapshots taken on the Pi can be restored on the host.
+Every cell of the board takes 3 bits, a row is packed into as few bytes
+as hold them (one word on the standard board); the row masks, skyline
+and fill counts are rebuilt on restore.
+*/
+
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_ROW_BYTES ((3*NUM_COLS + 7) / 8)
+#define SNAPSHOT_SIZE (1 + NUM_ROWS*SNAPSHOT_ROW_BYTES + 4 + 4*3 + 16 + 4 + (PIECE_PREVIEW + 1)/2)
+
+#if NUM_COLS > 21
+#error "a snapshot packs a row of 3-bit cells into one 64-bit word"
+#endif
+
+typedef struct {
+    unsigned char bytes[SNAPSHOT_SIZE];
+} snapshot_t;
+
+/* 'snapshot_take'
+
+Saves the complete state of the game into 'snapshot'.
+*/
+void snapshot_take(const engine_t *engine, snapshot_t *snapshot);
+
+/* 'snapshot_restore'
+
+Puts the game back in the state saved in 'snapshot'. Returns 1 on
+success, 0 if the snapshot is from an incompatible version.
+*/
+unsigned int snapshot_restore(engine_t *engine, const snapshot_t *snapshot);
+
+#endif
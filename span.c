@@ -0,0 +1,271 @@
+#include "span.h"
+#include "fb.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SPAN_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__arm__) && !defined(__thumb__)
+#define SPAN_ARM 1
+#endif
+
+// Lets a kernel store two pixels at once without breaking aliasing rules
+typedef unsigned long long pair_t __attribute__((may_alias));
+
+/* Private helper that returns how many pixels from 'to' on come before
+   the next 'bytes' boundary, at most 'count'. */
+static inline int head(const color_t *to, int count, int bytes) {
+    int misaligned = ((unsigned long)to & (bytes - 1)) / sizeof(color_t);
+    int before = misaligned ? bytes / sizeof(color_t) - misaligned : 0;
+    return before < count ? before : count;
+}
+
+static inline void fill_words(color_t *to, int count, color_t color) {
+    for (int i = 0; i < count; i++) {
+        to[i] = color;
+    }
+}
+
+static inline void copy_words(color_t *to, const color_t *from, int count) {
+    for (int i = 0; i < count; i++) {
+        to[i] = from[i];
+    }
+}
+
+static inline void fill_u64(color_t *to, int count, color_t color) {
+    int before = head(to, count, sizeof(pair_t));
+    fill_words(to, before, color);
+    to += before;
+    count -= before;
+
+    pair_t pair = (pair_t)color << 32 | color;
+    pair_t *pairs = (pair_t *)to;
+    for (int i = 0; i < count / 2; i++) {
+        pairs[i] = pair;
+    }
+    if (count & 1) to[count - 1] = color;
+}
+
+static inline void copy_u64(color_t *to, const color_t *from, int count) {
+    int before = head(to, count, sizeof(pair_t));
+    copy_words(to, from, before);
+    to += before;
+    from += before;
+    count -= before;
+
+    // Pairs only line up when the source has the same alignment
+    if ((unsigned long)from & (sizeof(pair_t) - 1)) {
+        copy_words(to, from, count);
+        return;
+    }
+    pair_t *pairs = (pair_t *)to;
+    const pair_t *source = (const pair_t *)from;
+    for (int i = 0; i < count / 2; i++) {
+        pairs[i] = source[i];
+    }
+    if (count & 1) to[count - 1] = from[count - 1];
+}
+
+#ifdef SPAN_ARM
+
+static inline void fill_stm(color_t *to, int count, color_t color) {
+    int before = head(to, count, 16);
+    fill_words(to, before, color);
+    to += before;
+    count -= before;
+
+    int bursts = count / 8;
+    if (bursts > 0) {
+        __asm__ volatile(
+            "mov r4, %[color]\n\t"
+            "mov r5, %[color]\n\t"
+            "mov r6, %[color]\n\t"
+            "mov r8, %[color]\n"
+            "1:\n\t"
+            "stmia %[to]!, {r4, r5, r6, r8}\n\t"
+            "stmia %[to]!, {r4, r5, r6, r8}\n\t"
+            "subs %[bursts], %[bursts], #1\n\t"
+            "bne 1b"
+            : [to] "+r" (to), [bursts] "+r" (bursts)
+            : [color] "r" (color)
+            : "r4", "r5", "r6", "r8", "cc", "memory");
+    }
+    fill_words(to, count & 7, color);
+}
+
+static inline void copy_stm(color_t *to, const color_t *from, int count) {
+    int before = head(to, count, 16);
+    copy_words(to, from, before);
+    to += before;
+    from += before;
+    count -= before;
+
+    // ldm only needs word alignment, which every pixel has
+    int bursts = count / 8;
+    if (bursts > 0) {
+        __asm__ volatile(
+            "1:\n\t"
+            "ldmia %[from]!, {r4, r5, r6, r8}\n\t"
+            "stmia %[to]!, {r4, r5, r6, r8}\n\t"
+            "ldmia %[from]!, {r4, r5, r6, r8}\n\t"
+            "stmia %[to]!, {r4, r5, r6, r8}\n\t"
+            "subs %[bursts], %[bursts], #1\n\t"
+            "bne 1b"
+            : [to] "+r" (to), [from] "+r" (from), [bursts] "+r" (bursts)
+            :
+            : "r4", "r5", "r6", "r8", "cc", "memory");
+    }
+    copy_words(to, from, count & 7);
+}
+
+#endif
+
+#ifdef SPAN_X86
+
+// The vector kernels cover the ragged head and tail of a span with one
+// unaligned store each, overlapping the aligned stores in between
+
+__attribute__((target("sse2")))
+static inline void fill_sse2(color_t *to, int count, color_t color) {
+    if (count < 4) {
+        fill_words(to, count, color);
+        return;
+    }
+
+    __m128i wide = _mm_set1_epi32((int)color);
+    _mm_storeu_si128((__m128i *)to, wide);
+    for (int i = head(to, count, 16); i + 4 <= count; i += 4) {
+        _mm_store_si128((__m128i *)(to + i), wide);
+    }
+    _mm_storeu_si128((__m128i *)(to + count - 4), wide);
+}
+
+__attribute__((target("sse2")))
+static inline void copy_sse2(color_t *to, const color_t *from, int count) {
+    if (count < 4) {
+        copy_words(to, from, count);
+        return;
+    }
+
+    _mm_storeu_si128((__m128i *)to, _mm_loadu_si128((const __m128i *)from));
+    for (int i = head(to, count, 16); i + 4 <= count; i += 4) {
+        _mm_store_si128((__m128i *)(to + i), _mm_loadu_si128((const __m128i *)(from + i)));
+    }
+    _mm_storeu_si128((__m128i *)(to + count - 4), _mm_loadu_si128((const __m128i *)(from + count - 4)));
+}
+
+__attribute__((target("avx")))
+static inline void fill_avx(color_t *to, int count, color_t color) {
+    if (count < 8) {
+        fill_sse2(to, count, color);
+        return;
+    }
+
+    __m256i wide = _mm256_set1_epi32((int)color);
+    _mm256_storeu_si256((__m256i *)to, wide);
+    for (int i = head(to, count, 32); i + 8 <= count; i += 8) {
+        _mm256_store_si256((__m256i *)(to + i), wide);
+    }
+    _mm256_storeu_si256((__m256i *)(to + count - 8), wide);
+}
+
+__attribute__((target("avx")))
+static inline void copy_avx(color_t *to, const color_t *from, int count) {
+    if (count < 8) {
+        copy_sse2(to, from, count);
+        return;
+    }
+
+    _mm256_storeu_si256((__m256i *)to, _mm256_loadu_si256((const __m256i *)from));
+    for (int i = head(to, count, 32); i + 8 <= count; i += 8) {
+        _mm256_store_si256((__m256i *)(to + i), _mm256_loadu_si256((const __m256i *)(from + i)));
+    }
+    _mm256_storeu_si256((__m256i *)(to + count - 8), _mm256_loadu_si256((const __m256i *)(from + count - 8)));
+}
+
+#endif
+
+/* Each kernel walks the rows of a rectangle itself, so the row code is
+   inlined into the loop and a rectangle costs one call through the
+   table instead of one per row. */
+#define RECT_KERNELS(name, target) \
+    target static void fill_rect_##name(color_t *to, int pitch, int w, int h, color_t color) { \
+        for (int row = 0; row < h; row++, to += pitch) { \
+            fill_##name(to, w, color); \
+        } \
+    } \
+    target static void copy_rect_##name(color_t *to, int to_pitch, const color_t *from, int from_pitch, \
+                                        int w, int h) { \
+        for (int row = 0; row < h; row++, to += to_pitch, from += from_pitch) { \
+            copy_##name(to, from, w); \
+        } \
+    }
+
+RECT_KERNELS(words, )
+RECT_KERNELS(u64, )
+#ifdef SPAN_ARM
+RECT_KERNELS(stm, )
+#endif
+#ifdef SPAN_X86
+RECT_KERNELS(sse2, __attribute__((target("sse2"))))
+RECT_KERNELS(avx, __attribute__((target("avx"))))
+#endif
+
+static const span_kernel_t KERNELS[] = {
+    {"words", 4, fill_rect_words, copy_rect_words},
+    {"u64", 8, fill_rect_u64, copy_rect_u64},
+#ifdef SPAN_ARM
+    {"stm", 32, fill_rect_stm, copy_rect_stm},
+#endif
+#ifdef SPAN_X86
+    {"sse2", 16, fill_rect_sse2, copy_rect_sse2},
+    {"avx", 32, fill_rect_avx, copy_rect_avx},
+#endif
+};
+
+int span_kernels(const span_kernel_t **kernels) {
+    int count = sizeof(KERNELS) / sizeof(KERNELS[0]);
+#ifdef SPAN_X86
+    __builtin_cpu_init();
+    if (!__builtin_cpu_supports("avx")) count--;
+    if (!__builtin_cpu_supports("sse2")) count--;
+#endif
+    *kernels = KERNELS;
+    return count;
+}
+
+/* Private helper that returns the widest kernel, found on first use. */
+static const span_kernel_t *widest(void) {
+    static const span_kernel_t *kernel;
+
+    if (kernel == 0) {
+        const span_kernel_t *kernels;
+        int count = span_kernels(&kernels);
+        kernel = &kernels[count - 1];
+    }
+    return kernel;
+}
+
+void span_fill(color_t *to, int count, color_t color) {
+    widest()->fill(to, 0, count, 1, color);
+}
+
+void span_copy(color_t *to, const color_t *from, int count) {
+    widest()->copy(to, 0, from, 0, count, 1);
+}
+
+void span_copy_rect(color_t *to, int to_pitch, const color_t *from, int from_pitch, int w, int h) {
+    widest()->copy(to, to_pitch, from, from_pitch, w, h);
+}
+
+void span_fill_rect(int x, int y, int w, int h, color_t color) {
+    int right = x + w > (int)fb_get_width() ? (int)fb_get_width() : x + w;
+    int bottom = y + h > (int)fb_get_height() ? (int)fb_get_height() : y + h;
+    if (x < 0) x = 0;
+    if (y < 0) y = 0;
+    if (x >= right || y >= bottom) return;
+
+    int pitch = fb_get_pitch() / sizeof(color_t);
+    widest()->fill((color_t *)fb_get_draw_buffer() + y*pitch + x, pitch, right - x, bottom - y, color);
+}
@@ -0,0 +1,70 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include "gl.h"
+
+/* Module for the row kernels everything on screen is drawn with.
+
+A span is a run of pixels in one row of a buffer. Filling or copying a
+rectangle is one span per row, and the kernels here do a span with the
+widest stores the CPU has instead of a store per pixel:
+  words: one 32-bit store per pixel, what gl_draw_rect does.
+  u64:   two pixels per store.
+  stm:   on the Pi, bursts of eight pixels with two stm instructions of
+         four registers each, after single stores up to a 16-byte
+         boundary.
+  sse2:  on x86 hosts, 128-bit stores, four pixels.
+  avx:   on x86 hosts that have it, 256-bit stores, eight pixels.
+Each one stores aligned through the middle of the span. The u64 and
+stm kernels do the head up to the first aligned pixel and the tail
+after the last full store one pixel at a time; the vector kernels cover
+each with a single unaligned store overlapping the aligned ones, which
+is the same pixels written twice. Copies load with whatever alignment
+the source has. span_fill() and span_copy() use the widest kernel.
+*/
+
+// A kernel fills or copies a 'w' x 'h' rectangle, its rows 'pitch' pixels apart
+typedef struct {
+    const char *name;
+    int bytes; // stored at a time
+    void (*fill)(color_t *to, int pitch, int w, int h, color_t color);
+    void (*copy)(color_t *to, int to_pitch, const color_t *from, int from_pitch, int w, int h);
+} span_kernel_t;
+
+/* 'span_fill'
+
+Sets 'count' pixels from 'to' on to 'color'.
+*/
+void span_fill(color_t *to, int count, color_t color);
+
+/* 'span_copy'
+
+Copies 'count' pixels from 'from' to 'to', which must not overlap.
+*/
+void span_copy(color_t *to, const color_t *from, int count);
+
+/* 'span_copy_rect'
+
+Copies a 'w' x 'h' pixel rectangle from 'from' to 'to', a row at a
+time, stepping 'from_pitch' and 'to_pitch' pixels from one row to the
+next. No row may overlap another it is copied to or from; with negative
+pitches the rows go bottom up, so a rectangle can be moved down over
+itself.
+*/
+void span_copy_rect(color_t *to, int to_pitch, const color_t *from, int from_pitch, int w, int h);
+
+/* 'span_fill_rect'
+
+Fills a rectangle of the draw buffer with 'color', clipped to the
+screen: the same pixels as gl_draw_rect, a span at a time.
+*/
+void span_fill_rect(int x, int y, int w, int h, color_t color);
+
+/* 'span_kernels'
+
+Points 'kernels' at the kernels this CPU supports, narrowest first, and
+returns how many there are.
+*/
+int span_kernels(const span_kernel_t **kernels);
+
+#endif
@@ -0,0 +1,36 @@
+#include "tile.h"
+#include "fb.h"
+#include "span.h"
+
+void tile_square(tile_t *tile, int size, int border, color_t fill) {
+    tile->size = size;
+    tile->fill = fill;
+
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            int edge = x < border || y < border || x >= size - border || y >= size - border;
+            tile->pixels[y*size + x] = edge ? GL_BLACK : fill;
+        }
+    }
+}
+
+const tile_t *tile_find(const tile_t *tiles, int count, int size, color_t fill) {
+    for (int i = 0; i < count; i++) {
+        if (tiles[i].size == size && tiles[i].fill == fill) return &tiles[i];
+    }
+    return 0;
+}
+
+int tile_blit(const tile_t *tile, int x, int y) {
+    int size = tile->size;
+    int pitch = fb_get_pitch() / sizeof(color_t);
+    int left = x < 0 ? -x : 0;
+    int top = y < 0 ? -y : 0;
+    int right = x + size > (int)fb_get_width() ? (int)fb_get_width() - x : size;
+    int bottom = y + size > (int)fb_get_height() ? (int)fb_get_height() - y : size;
+    if (left >= right || top >= bottom) return 0;
+
+    color_t *to = (color_t *)fb_get_draw_buffer() + (y + top)*pitch + x + left;
+    span_copy_rect(to, pitch, tile->pixels + top*size + left, size, right - left, bottom - top);
+    return (right - left) * (bottom - top);
+}
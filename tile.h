@@ -0,0 +1,45 @@
+#ifndef TILE_H
+#define TILE_H
+
+#include "gl.h"
+
+/* Module for pre-rendered square tiles.
+
+A block is a square of one color with a black outline. Drawn with
+gl_draw_rect that takes a fill and four outline rectangles, writing the
+outline twice and clipping each rectangle anew. A tile is the same square
+rendered once into memory, so drawing a block becomes a blit of its rows
+into the draw buffer with span_copy(), each pixel written once.
+*/
+
+#define TILE_MAX_SIZE 64 // in pixels, enough for BLOCK_SIZE and the title blocks
+
+typedef struct {
+    int size; // width and height in pixels
+    color_t fill; // color inside the outline
+    color_t pixels[TILE_MAX_SIZE * TILE_MAX_SIZE]; // 'size' rows of 'size' pixels
+} tile_t;
+
+/* 'tile_square'
+
+Renders a 'size' pixel square of color 'fill' with a black outline
+'border' pixels wide, 0 for none, exactly as drawing the fill and then
+the four sides of the outline with gl_draw_rect would.
+*/
+void tile_square(tile_t *tile, int size, int border, color_t fill);
+
+/* 'tile_find'
+
+Returns the tile among 'count' of them that is 'size' pixels of color
+'fill', or NULL if there is none.
+*/
+const tile_t *tile_find(const tile_t *tiles, int count, int size, color_t fill);
+
+/* 'tile_blit'
+
+Copies a tile into the draw buffer with its top left corner at x, y,
+clipped to the screen. Returns the pixels written.
+*/
+int tile_blit(const tile_t *tile, int x, int y);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+/* The game's timing on the Pi, kept in one place so host/sim plays its
+games on the same schedule as mymodule.c.
+
+The armtimer fires every ARM_TIMER_START_US. Gravity moves the shape on
+one interrupt in ARM_TIMER_START_COUNTER + 1, and the others poll the
+glove's sensor. Once SPEED_ROWS rows are cleared the armtimer fires
+every ARM_TIMER_SPEED_US instead. A line clear stops it for its
+animation, CLEAR_BLANK_MS and then CLEAR_SCROLL_MS.
+*/
+
+#define ARM_TIMER_START_US 50000 // armtimer period at the start of a game
+#define ARM_TIMER_SPEED_US 200000 // armtimer period once SPEED_ROWS rows are cleared
+#define SPEED_ROWS 5
+#define ARM_TIMER_START_COUNTER 10 // sensor polls between two gravity steps
+#define BOT_INPUT_MS 150 // pause before each input the bot makes
+#define CLEAR_BLANK_MS 200 // before the cleared rows are blanked
+#define CLEAR_SCROLL_MS 1000 // with them blank, before the rows above scroll down
+
+#endif
@@ -0,0 +1,102 @@
+#include "tt.h"
+
+// data: score in bits 0-31, move in 32-47, depth in 48-55, age in 56-63
+#define DATA(score, move, depth, age) ((unsigned int)(score) | (unsigned long long)(move) << 32 | \
+                                       (unsigned long long)(depth) << 48 | (unsigned long long)(age) << 56)
+#define DATA_SCORE(data) ((int)(unsigned int)(data))
+#define DATA_MOVE(data) ((unsigned int)((data) >> 32) & 0xFFFF)
+#define DATA_DEPTH(data) ((int)((data) >> 48) & 0xFF)
+#define DATA_AGE(data) ((unsigned char)((data) >> 56))
+
+unsigned long tt_init(tt_t *tt, tt_entry_t *memory, unsigned long bytes) {
+    unsigned long buckets = 1;
+    while (buckets * 2 * TT_BUCKET * sizeof(tt_entry_t) <= bytes) {
+        buckets *= 2;
+    }
+    if (buckets * TT_BUCKET * sizeof(tt_entry_t) > bytes) {
+        buckets = 0;
+    }
+
+    tt->entries = memory;
+    tt->buckets = buckets;
+    tt->age = 0;
+    tt->hits = tt->misses = tt->stores = tt->replaced = 0;
+
+    for (unsigned long i = 0; i < buckets * TT_BUCKET; i++) {
+        tt->entries[i].check = 0;
+        tt->entries[i].data = 0;
+    }
+    return buckets * TT_BUCKET;
+}
+
+void tt_new_search(tt_t *tt) {
+    tt->age++;
+}
+
+/* Private helper that scrambles the bits of a key (splitmix64's finalizer). */
+static unsigned long long mix(unsigned long long z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+unsigned long long tt_key(unsigned long long hash, const unsigned char *queue, int count) {
+    // Three bits per shape and the count, so queues of different lengths differ too
+    unsigned long long shapes = count;
+    for (int i = 0; i < count; i++) {
+        shapes = (shapes << 3) | queue[i];
+    }
+    return hash ^ mix(shapes + 0x9E3779B97F4A7C15ull);
+}
+
+int tt_probe(tt_t *tt, unsigned long long key, int *score, unsigned int *move) {
+    if (tt->buckets == 0) {
+        return 0;
+    }
+
+    volatile tt_entry_t *bucket = &tt->entries[(key & (tt->buckets - 1)) * TT_BUCKET];
+    for (int i = 0; i < TT_BUCKET; i++) {
+        unsigned long long data = bucket[i].data;
+        if ((bucket[i].check ^ data) == key && data != 0) {
+            *score = DATA_SCORE(data);
+            *move = DATA_MOVE(data);
+            tt->hits++;
+            return 1;
+        }
+    }
+
+    tt->misses++;
+    return 0;
+}
+
+void tt_store(tt_t *tt, unsigned long long key, int depth, int score, unsigned int move) {
+    if (tt->buckets == 0) {
+        return;
+    }
+
+    volatile tt_entry_t *bucket = &tt->entries[(key & (tt->buckets - 1)) * TT_BUCKET];
+    volatile tt_entry_t *victim = &bucket[0];
+    int victim_rank = 1 << 30;
+
+    for (int i = 0; i < TT_BUCKET; i++) {
+        unsigned long long data = bucket[i].data;
+        if (data == 0 || (bucket[i].check ^ data) == key) { // empty, or the same position
+            victim = &bucket[i];
+            victim_rank = -1;
+            break;
+        }
+
+        // Old searches go first, then shallow ones
+        int rank = (DATA_AGE(data) == tt->age ? 256 : 0) + DATA_DEPTH(data);
+        if (rank < victim_rank) {
+            victim = &bucket[i];
+            victim_rank = rank;
+        }
+    }
+
+    unsigned long long data = DATA(score, move, depth, tt->age);
+    if (victim_rank >= 0) tt->replaced++;
+    tt->stores++;
+    victim->data = data;
+    victim->check = key ^ data;
+}
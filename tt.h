@@ -0,0 +1,83 @@
+#ifndef TT_H
+#define TT_H
+
+/* Module for a transposition table: a fixed-size cache of searched
+positions for the bot's lookahead.
+
+A position is the board plus the shapes still to be placed, and its key
+is the board's Zobrist hash mixed with those shapes (see tt_key()). The
+table stores the score the search found for a position and the move it
+picked there, so a position reached again, through another move order
+or on a later turn, is not searched twice.
+
+The table lives in memory handed to tt_init(), so its size is the
+caller's memory budget and nothing is allocated. Entries are grouped in
+buckets of TT_BUCKET. A store goes to the entry holding the same key,
+else to an entry left over from an older search, else to the one
+searched to the smallest depth.
+
+Probes and stores take no locks, so threads can share one table. Each
+entry keeps its key XORed with its data: an entry torn by two threads
+writing it at once no longer matches its key and reads as a miss. The
+hit and miss counters are not atomic and may lose counts when shared.
+
+The age is not shared safely: tt_new_search() is a plain increment, and
+the age tells the current search's entries from older ones. Threads
+searching on their own schedules would each move it, and race doing so,
+so each of them needs its own table. Threads may share one only if a
+single thread starts every search while the others are not using it.
+*/
+
+#define TT_BUCKET 4 // entries per bucket, 64 bytes
+
+typedef struct {
+    unsigned long long check; // key ^ data
+    unsigned long long data; // score, move, depth and age of the search
+} tt_entry_t;
+
+typedef struct {
+    volatile tt_entry_t *entries;
+    unsigned long buckets; // a power of two
+    unsigned char age; // bumped by tt_new_search(), by one thread only
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long stores;
+    unsigned long long replaced; // stores that evicted another position
+} tt_t;
+
+/* 'tt_init'
+
+Sets up an empty table in the 'bytes' bytes at 'memory'. It uses the
+largest power of two buckets that fits. Returns the number of entries.
+*/
+unsigned long tt_init(tt_t *tt, tt_entry_t *memory, unsigned long bytes);
+
+/* 'tt_new_search'
+
+Marks every entry as left over from an older search, so new results
+replace them first. Call it once per shape.
+*/
+void tt_new_search(tt_t *tt);
+
+/* 'tt_key'
+
+Returns the key of the board with Zobrist hash 'hash' when the shapes
+queue[0..count) are still to be placed, in that order.
+*/
+unsigned long long tt_key(unsigned long long hash, const unsigned char *queue, int count);
+
+/* 'tt_probe'
+
+Looks the position up. Returns 1 and sets 'score' and 'move' if the
+table has it, 0 if not.
+*/
+int tt_probe(tt_t *tt, unsigned long long key, int *score, unsigned int *move);
+
+/* 'tt_store'
+
+Records the score and move the search found for the position, searched
+'depth' shapes deep.
+*/
+void tt_store(tt_t *tt, unsigned long long key, int depth, int score, unsigned int move);
+
+#endif